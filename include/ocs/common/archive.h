@@ -0,0 +1,87 @@
+/**
+ * @file   archive.h
+ * @author Dennis Sitelew
+ * @date   Oct. 18, 2026
+ */
+#pragma once
+
+#include <ocs/common/database.h>
+
+#include <sqlite-burrito/versioned_database.h>
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ocs::common {
+
+//! A single database, consolidating the OCR results of many per-video databases.
+class archive {
+private:
+   static const int CURRENT_DB_VERSION;
+
+   using statement_t = sqlite_burrito::statement;
+
+public:
+   enum class merge_result {
+      //! Database contents were (re-)merged into the archive
+      merged,
+
+      //! Database didn't change since the last merge
+      unchanged,
+
+      //! Database has an older (or newer) schema, it has to be migrated with `ocs-migrate` before being merged
+      outdated,
+   };
+
+   //! Search results of a single archived video
+   struct video_entries {
+      std::string video_path;
+
+      //! Absolute recording start time (milliseconds since epoch, UTC)
+      std::chrono::milliseconds start_time;
+      double frame_rate;
+
+      std::vector<database::search_entry> entries;
+   };
+
+public:
+   explicit archive(std::string db_path, bool read_only = false);
+
+public:
+   /**
+    * Merge a per-video database into the archive.
+    *
+    * Merging is idempotent: a database is only re-merged if it changed since the last merge (size, modification time
+    * or change counter), in which case all the video entries are replaced. The database itself is only read.
+    */
+   merge_result merge(const std::string &db_path, const std::string &video_path);
+
+   //! Find the spans of the texts matching the LIKE pattern in all the archived videos, ordered by the video
+   void find_text(const std::string &text, std::vector<video_entries> &results);
+
+   //! Abort the query running on this archive, may be called from any thread
+   void interrupt();
+
+private:
+   static void db_update(sqlite_burrito::versioned_database &con, int from, std::error_code &ec);
+
+   void prepare_statements();
+
+   static double probe_frame_rate(const std::string &video_path);
+
+private:
+   bool read_only_;
+   std::string db_path_;
+   sqlite_burrito::versioned_database db_;
+
+   statement_t get_video_;
+   statement_t upsert_video_;
+   statement_t find_text_;
+
+   mutable std::recursive_mutex database_mutex_{};
+};
+
+} // namespace ocs::common
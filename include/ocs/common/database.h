@@ -4,11 +4,16 @@
 
 #pragma once
 
+#include <ocs/common/fuzzy_match.h>
 #include <ocs/common/ocr_result.h>
 
 #include <sqlite-burrito/versioned_database.h>
 
+#include <chrono>
 #include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
 
 struct sqlite3;
 
@@ -16,19 +21,66 @@ namespace ocs::common {
 
 //! A class for storing the results of the OCR process in a sqlite3 database.
 class database {
-private:
+public:
+   //! Schema version of the databases written by this build, the older ones are migrated when opened writable
    static const int CURRENT_DB_VERSION;
 
+private:
    using statement_t = sqlite_burrito::statement;
 
 public:
    struct search_entry {
+      //! First frame of the text appearance span
       int frame_number;
+
+      //! Last frame of the text appearance span
+      int last_frame_number;
+
       std::string text;
       int left, top, right, bottom;
       float confidence;
    };
 
+   //! Controls how consecutive text appearances are merged into spans
+   struct span_options {
+      //! Maximal distance (in frames) between two appearances of the same text, for them to be merged into one span
+      std::int64_t max_frame_gap{30};
+
+      //! Maximal difference (in pixels) of each bounding box coordinate, for two boxes to be considered the same
+      int max_box_delta{4};
+
+      //! OCR results are arriving slightly out of order, so the spans are kept open for twice the gap size
+      [[nodiscard]] std::int64_t open_span_frames() const { return 2 * max_frame_gap; }
+   };
+
+   //! A rectangular area of the frame, in pixels
+   struct region {
+      int left, top, right, bottom;
+   };
+
+   //! A distinct recognized text
+   struct text_value {
+      std::int64_t id;
+      std::string value;
+   };
+
+   //! Properties of the video file, stored at ingest, so that the video doesn't have to be opened at search time
+   struct video_info {
+      double frame_rate{0.0};
+      int time_base_num{0};
+      int time_base_den{1};
+
+      //! Known length of the video. For a recording which is still being written, this only covers the frames
+      //! processed so far, so it grows as the frames are stored.
+      std::optional<std::chrono::milliseconds> duration{};
+      std::optional<std::int64_t> frame_count{};
+
+      //! Absolute recording start time (milliseconds since epoch, UTC)
+      std::optional<std::chrono::milliseconds> start_time{};
+
+      [[nodiscard]] std::chrono::milliseconds frame_number_to_milliseconds(std::int64_t frame_number) const;
+   };
+
 public:
    explicit database(std::string db_path, bool read_only = false);
 
@@ -36,17 +88,139 @@ public:
    void store(const ocr_result &result);
 
    std::int64_t get_starting_frame_number();
+
+   //! @return true if the frame was processed by one of the previous runs, i.e. it's not above the high-water mark
+   //!         (the last processed frame) the database was opened with
+   //! @note The frames below the mark which were still being processed when the previous run was interrupted are
+   //!       considered processed as well
    bool is_frame_processed(std::int64_t frame_num);
 
    void store_last_frame_number(std::int64_t frame_num);
 
    void find_text(const std::string &text, std::vector<search_entry> &entries);
 
+   //! Search only the spans starting in the [min_frame, max_frame] range, used to split a large database into parts
+   void find_text(const std::string &text,
+                  std::int64_t min_frame,
+                  std::int64_t max_frame,
+                  std::vector<search_entry> &entries);
+
+   //! Search only the spans starting in the [min_frame, max_frame] range and lasting at least until `min_last_frame`.
+   //! A span changed by storing a frame always lasts until that frame, so this finds all the spans changed since the
+   //! `min_last_frame` was stored, e.g. to search only the new part of a database that is still being written.
+   void find_text(const std::string &text,
+                  std::int64_t min_frame,
+                  std::int64_t max_frame,
+                  std::int64_t min_last_frame,
+                  std::vector<search_entry> &entries);
+
+   //! Search only the spans visible on any of the [min_frame, max_frame] frames, including the ones started before
+   //! the range. Unlike the first frame ranges, the results of the adjacent ranges might share the spans.
+   void find_text_overlapping(const std::string &text,
+                              std::int64_t min_frame,
+                              std::int64_t max_frame,
+                              std::vector<search_entry> &entries);
+
+   //! Find the spans of the text, with the box overlapping the region
+   void find_text_in_region(const std::string &text, const region &area, std::vector<search_entry> &entries);
+
+   //! Same as above, only the spans visible on any of the [min_frame, max_frame] frames
+   void find_text_in_region(const std::string &text,
+                            const region &area,
+                            std::int64_t min_frame,
+                            std::int64_t max_frame,
+                            std::vector<search_entry> &entries);
+
+   //! Find the pairs of spans of both texts visible on the same frames, with the gap between the boxes at most
+   //! `max_distance` pixels (both horizontally and vertically). Both spans of each pair are returned, clipped to the
+   //! common frames. A span might be returned multiple times, if it's close to multiple spans of the other text.
+   void find_text_near(const std::string &text,
+                       const std::string &other_text,
+                       int max_distance,
+                       std::vector<search_entry> &entries);
+
+   //! Same as above, only the pairs with the first span visible on any of the [min_frame, max_frame] frames
+   void find_text_near(const std::string &text,
+                       const std::string &other_text,
+                       int max_distance,
+                       std::int64_t min_frame,
+                       std::int64_t max_frame,
+                       std::vector<search_entry> &entries);
+
+   //! Find the spans of the texts approximately containing the pattern. The (much smaller) dictionary of the distinct
+   //! texts is matched first, then only the spans of the matching texts are read.
+   void find_text_fuzzy(const fuzzy_pattern &pattern, std::vector<search_entry> &entries);
+
+   //! Same as above, only the spans visible on any of the [min_frame, max_frame] frames
+   void find_text_fuzzy(const fuzzy_pattern &pattern,
+                        std::int64_t min_frame,
+                        std::int64_t max_frame,
+                        std::vector<search_entry> &entries);
+
+   //! @return false if no text entry can match the LIKE pattern, according to the trigram filter. This is much
+   //!         cheaper than `find_text`, but might return true for the databases not containing the text.
+   bool may_contain(const std::string &pattern);
+
+   //! Read the distinct texts with the id greater than `after_id`, ordered by the id (ids are never reused)
+   void get_text_entries(std::int64_t after_id, std::vector<text_value> &entries);
+
+   //! Set the options of the spans being stored, those are recorded in the metadata for the readers as well
+   void set_span_options(const span_options &opts);
+
+   //! @return Number of frames before the last processed one, within which the spans might still be changed (or
+   //!         merged together) by the writer, or std::nullopt if the writer didn't record its span options
+   std::optional<std::int64_t> get_span_overlap();
+
+   void store_video_info(const video_info &info);
+
+   //! @return Stored video properties, or std::nullopt for databases created before those were recorded
+   std::optional<video_info> get_video_info();
+
+   //! @return Thumbnail of the frame, or std::nullopt if no thumbnail was stored for it at ingest
+   std::optional<thumbnail> get_thumbnail(std::int64_t frame_number);
+
+   //! Rebuild the database file, reclaiming the space freed by the migrations
+   void vacuum();
+
+   //! Abort the query running on this database, may be called from any thread
+   void interrupt();
+
+   //! @return Change counter of the database file, read from its header without opening it, or 0 if the file has no
+   //!         header yet. SQLite increments it by every write transaction, so unlike the size and the modification
+   //!         time (with its 1s resolution), it tells apart every change of a database which is still being written.
+   static std::uint32_t read_change_counter(const std::string &db_path);
+
+private:
+   //! A span, which can still be extended by the frames being stored
+   struct open_span {
+      std::int64_t first_frame;
+      std::int64_t last_frame;
+      std::int64_t box;
+      int left, top, right, bottom;
+      int confidence;
+   };
+
+   using open_spans_t = std::unordered_map<std::int64_t, std::vector<open_span>>;
+
 private:
    static void db_update(sqlite_burrito::versioned_database &con, int from, std::error_code &ec);
 
    void prepare_statements();
 
+   void load_open_spans();
+   void close_stale_spans();
+   void add_to_span(std::int64_t text_id, std::int64_t frame_num, const text_entry &entry);
+
+   //! Remove the span, merging its last frame and confidence into the given ones
+   //! @return true if the span existed
+   bool remove_text_span(std::int64_t text_id,
+                         std::int64_t first_frame,
+                         std::int64_t box,
+                         std::int64_t &last_frame,
+                         int &confidence);
+   void add_to_trigram_filter(const std::string &text);
+   void add_thumbnail(const thumbnail &thumb);
+
 private:
    bool read_only_;
    std::string db_path_;
@@ -54,14 +228,42 @@ private:
 
    statement_t add_text_entry_;
    statement_t get_text_entry_id_;
-   statement_t add_text_instance_;
+   statement_t add_text_span_;
+   statement_t update_text_span_;
+   statement_t remove_text_span_;
+   statement_t get_open_spans_;
 
    statement_t get_starting_frame_number_;
-   statement_t is_frame_number_present_;
 
    statement_t store_last_frame_number_;
 
    statement_t find_text_;
+   statement_t find_text_crossing_;
+   statement_t find_text_in_region_;
+   statement_t find_text_near_;
+   statement_t get_text_spans_;
+   statement_t get_text_entries_;
+
+   statement_t add_trigram_filter_bits_;
+   statement_t get_trigram_filter_word_;
+
+   statement_t store_video_info_;
+   statement_t get_video_info_;
+
+   statement_t store_span_options_;
+   statement_t get_span_options_;
+
+   statement_t add_thumbnail_;
+   statement_t get_thumbnail_;
+
+   span_options span_options_{};
+   open_spans_t open_spans_{};
+   bool open_spans_loaded_{false};
+   std::int64_t max_stored_frame_{-1};
+
+   //! Last frame processed by the previous runs, and the last one stored in the metadata by this one
+   std::int64_t resume_frame_{-1};
+   std::int64_t last_frame_number_{-1};
 
    mutable std::recursive_mutex database_mutex_{};
 };
@@ -0,0 +1,126 @@
+/**
+ * @file   fuzzy_match.h
+ * @author Dennis Sitelew
+ * @date   Oct. 18, 2026
+ *
+ * Approximate search of a text, tolerating the OCR errors: the characters the OCR commonly confuses are considered
+ * equal, and up to the given number of characters might be inserted, removed or replaced.
+ *
+ * Note: the texts are compared byte by byte, so a replaced multibyte UTF-8 character might cost more than one edit.
+ */
+#pragma once
+
+#include <ocs/common/trigrams.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+namespace ocs::common {
+
+//! @return The character representing the whole class of the characters the OCR confuses with `c`
+constexpr unsigned char ocr_canonical(char c) {
+   switch (const auto folded = fold_case(c)) {
+      case '0':
+         return 'o';
+
+      case '1':
+      case 'i':
+      case '|':
+         return 'l';
+
+      case '2':
+         return 'z';
+
+      case '5':
+         return 's';
+
+      case '8':
+         return 'b';
+
+      default:
+         return folded;
+   }
+}
+
+//! A pattern searched in the texts with Myers' bit-parallel algorithm, i.e. all the pattern characters are processed
+//! at once with a few 64-bit operations per text character
+class fuzzy_pattern {
+public:
+   static constexpr std::size_t max_length = 64;
+
+public:
+   //! @throws std::invalid_argument if the pattern is empty or longer than `max_length`
+   fuzzy_pattern(std::string_view pattern, int max_distance)
+      : length_{pattern.size()}
+      , max_distance_{max_distance} {
+      if (pattern.empty() || pattern.size() > max_length) {
+         throw std::invalid_argument("Fuzzy search pattern should be 1 to 64 characters long");
+      }
+
+      for (std::size_t i = 0; i < pattern.size(); ++i) {
+         peq_[ocr_canonical(pattern[i])] |= std::uint64_t{1} << i;
+      }
+   }
+
+public:
+   [[nodiscard]] std::size_t length() const { return length_; }
+   [[nodiscard]] int max_distance() const { return max_distance_; }
+
+   //! @return Smallest edit distance between the pattern and any substring of the text
+   [[nodiscard]] int distance(std::string_view text) const { return search(text, -1); }
+
+   //! @return true if some substring of the text is at most `max_distance` edits away from the pattern
+   [[nodiscard]] bool matches(std::string_view text) const { return search(text, max_distance_) <= max_distance_; }
+
+private:
+   //! Stops as soon as the distance is at most `good_enough`
+   [[nodiscard]] int search(std::string_view text, int good_enough) const {
+      const auto last_bit = std::uint64_t{1} << (length_ - 1);
+
+      // Vertical deltas of the current column of the DP matrix, the first row is all zeros, as the match may start
+      // anywhere in the text
+      std::uint64_t pv = ~std::uint64_t{0};
+      std::uint64_t mv = 0;
+      auto score = static_cast<int>(length_);
+      auto best = score;
+
+      for (const auto c : text) {
+         if (best <= good_enough) {
+            break;
+         }
+
+         const auto eq = peq_[ocr_canonical(c)];
+         const auto xv = eq | mv;
+         const auto xh = (((eq & pv) + pv) ^ pv) | eq;
+
+         auto ph = mv | ~(xh | pv);
+         auto mh = pv & xh;
+         if (ph & last_bit) {
+            ++score;
+         } else if (mh & last_bit) {
+            --score;
+         }
+
+         ph <<= 1U;
+         mh <<= 1U;
+         pv = mh | ~(xv | ph);
+         mv = ph & xv;
+
+         best = std::min(best, score);
+      }
+
+      return best;
+   }
+
+private:
+   //! Bit masks of the pattern positions holding each (canonical) character
+   std::array<std::uint64_t, 256> peq_{};
+
+   std::size_t length_;
+   int max_distance_;
+};
+
+} // namespace ocs::common
@@ -5,9 +5,12 @@
 #ifndef OCS_COMMON_OCR_RESULT_H
 #define OCS_COMMON_OCR_RESULT_H
 
+#include <ocs/common/thumbnail.h>
+
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <optional>
 
 namespace ocs::common {
 
@@ -20,6 +23,9 @@ struct text_entry {
 struct ocr_result {
    std::int64_t frame_number{};
    std::vector<text_entry> entries{};
+
+   //! Preview of the frame, stored together with the texts if requested
+   std::optional<thumbnail> preview{};
 };
 
 } // namespace ocs::common
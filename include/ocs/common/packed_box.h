@@ -0,0 +1,55 @@
+/**
+ * @file   packed_box.h
+ * @author Dennis Sitelew
+ * @date   Oct. 18, 2026
+ *
+ * Compact on-disk representation of the text bounding boxes and recognition confidences.
+ *
+ * Note: the database migrations are doing the same packing in SQL, those have to be kept in sync.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace ocs::common {
+
+//! Bounding box coordinates are stored as four 16-bit values in a single integer
+constexpr int box_coordinate_bits = 16;
+constexpr std::int64_t box_coordinate_max = (std::int64_t{1} << box_coordinate_bits) - 1;
+
+//! Confidence is stored as an integer percentage
+constexpr int confidence_max = 100;
+
+struct unpacked_box {
+   int left, top, right, bottom;
+};
+
+//! Note: the left coordinate ends up in the sign bit, so the packing is done unsigned. The result is the same as the
+//! SQLite shifts are giving, those work on the two's complement representation.
+constexpr std::int64_t pack_box(int left, int top, int right, int bottom) {
+   auto clamp = [](int value) {
+      return static_cast<std::uint64_t>(std::clamp<std::int64_t>(value, 0, box_coordinate_max));
+   };
+
+   const auto packed = (clamp(left) << (3 * box_coordinate_bits)) | (clamp(top) << (2 * box_coordinate_bits)) |
+                       (clamp(right) << box_coordinate_bits) | clamp(bottom);
+   return static_cast<std::int64_t>(packed);
+}
+
+constexpr unpacked_box unpack_box(std::int64_t box) {
+   const auto packed = static_cast<std::uint64_t>(box);
+   auto get = [&](int idx) { return static_cast<int>((packed >> (idx * box_coordinate_bits)) & box_coordinate_max); };
+   return {get(3), get(2), get(1), get(0)};
+}
+
+inline int quantize_confidence(float confidence) {
+   return std::clamp(static_cast<int>(std::lround(confidence)), 0, confidence_max);
+}
+
+constexpr float dequantize_confidence(int confidence) {
+   return static_cast<float>(confidence);
+}
+
+} // namespace ocs::common
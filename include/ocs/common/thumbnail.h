@@ -0,0 +1,38 @@
+/**
+ * @file   thumbnail.h
+ * @author Dennis Sitelew
+ * @date   Oct. 18, 2026
+ */
+#pragma once
+
+#include <ocs/ffmpeg/decoder.h>
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace ocs::common {
+
+//! A small JPEG preview of a video frame, made at ingest, so that the frame can be shown without decoding the video
+struct thumbnail {
+   std::int64_t frame_number{};
+
+   //! Size of the preview image
+   int width{};
+   int height{};
+
+   //! Size of the original frame, the text boxes are relative to it
+   int frame_width{};
+   int frame_height{};
+
+   std::vector<std::uint8_t> jpeg{};
+};
+
+//! @return The (RGB) frame scaled down to fit into `max_size` x `max_size` pixels and JPEG-encoded with the `quality`
+//!         (1 - 100). Frames smaller than that are not scaled.
+thumbnail make_thumbnail(const ffmpeg::decoder::frame &frame, int max_size, int quality);
+
+//! @return The decoded (RGB) preview image, or std::nullopt if the thumbnail can't be decoded
+std::optional<ffmpeg::decoder::frame> decode_thumbnail(const thumbnail &thumb);
+
+} // namespace ocs::common
@@ -0,0 +1,33 @@
+/**
+ * @file   timestamp.h
+ * @author Dennis Sitelew
+ * @date   Oct. 18, 2026
+ */
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace ocs::common::timestamp {
+
+//! Format of the video file names, used for deducing the recording start time, e.g.: 2023-01-14 17-05-42.mkv
+constexpr auto video_file_name_format = "%Y-%m-%d %H-%M-%S";
+
+//! @return Recording start time (milliseconds since the UNIX epoch), deduced from the video file name
+std::optional<std::chrono::milliseconds> start_time_for_video(const std::string &video_file);
+
+struct civil_date {
+   int year;
+   unsigned month;
+   unsigned day;
+};
+
+//! @return Number of days since the UNIX epoch for the given civil date
+std::int64_t days_from_civil(int year, unsigned month, unsigned day);
+
+//! @return Civil date of the day `days` since the UNIX epoch, the inverse of `days_from_civil`
+civil_date civil_from_days(std::int64_t days);
+
+} // namespace ocs::common::timestamp
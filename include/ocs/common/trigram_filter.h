@@ -0,0 +1,64 @@
+/**
+ * @file   trigram_filter.h
+ * @author Dennis Sitelew
+ * @date   Oct. 18, 2026
+ *
+ * Bloom filter over the trigrams of the text entries of a database, see trigrams.h. The filter is stored as 64-bit
+ * words, only the words having any bits set are stored.
+ *
+ * Note: the filters are stored in the databases, changing any of the parameters requires a migration.
+ */
+#pragma once
+
+#include <ocs/common/trigrams.h>
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+
+namespace ocs::common {
+
+//! Size of the filter: 2^20 bits (128 KiB) keep the false positive rate of a single trigram around 2% with 100k
+//! distinct trigrams, and a query usually has several of those
+constexpr int trigram_filter_size_bits = 20;
+constexpr int trigram_filter_hashes = 3;
+
+struct trigram_filter_bit {
+   std::int64_t word;
+   std::uint64_t mask;
+};
+
+using trigram_filter_bits_t = std::array<trigram_filter_bit, trigram_filter_hashes>;
+
+//! Words of the filter, with the bits to be set in them
+using trigram_filter_words_t = std::unordered_map<std::int64_t, std::uint64_t>;
+
+constexpr trigram_filter_bits_t trigram_filter_bits(trigram_t trigram) {
+   // splitmix64 finalizer, the two halves are used for the double hashing
+   std::uint64_t h = trigram + 0x9E3779B97F4A7C15ULL;
+   h = (h ^ (h >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+   h = (h ^ (h >> 27U)) * 0x94D049BB133111EBULL;
+   h = h ^ (h >> 31U);
+
+   const auto h1 = h >> 32U;
+   const auto h2 = (h & 0xFFFFFFFFULL) | 1U;
+   const auto bit_mask = (std::uint64_t{1} << trigram_filter_size_bits) - 1;
+
+   trigram_filter_bits_t result{};
+   for (std::size_t i = 0; i < result.size(); ++i) {
+      const auto bit = (h1 + i * h2) & bit_mask;
+      result[i] = {static_cast<std::int64_t>(bit >> 6U), std::uint64_t{1} << (bit & 63U)};
+   }
+   return result;
+}
+
+inline void add_to_trigram_filter(std::string_view text, trigram_filter_words_t &words) {
+   for (const auto trigram : text_trigrams(text)) {
+      for (const auto &bit : trigram_filter_bits(trigram)) {
+         words[bit.word] |= bit.mask;
+      }
+   }
+}
+
+} // namespace ocs::common
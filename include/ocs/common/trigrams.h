@@ -0,0 +1,68 @@
+/**
+ * @file   trigrams.h
+ * @author Dennis Sitelew
+ * @date   Oct. 18, 2026
+ *
+ * Trigrams of the recognized texts, used to rule out the databases which can't contain the searched text.
+ *
+ * Note: sqlite LIKE is case-insensitive for the ASCII characters only, so only those are folded here. Everything else
+ * (including multibyte UTF-8 sequences) is compared byte by byte.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace ocs::common {
+
+using trigram_t = std::uint32_t;
+
+constexpr unsigned char fold_case(char c) {
+   const auto uc = static_cast<unsigned char>(c);
+   return (uc >= 'A' && uc <= 'Z') ? static_cast<unsigned char>(uc - 'A' + 'a') : uc;
+}
+
+constexpr trigram_t make_trigram(char a, char b, char c) {
+   return (trigram_t{fold_case(a)} << 16U) | (trigram_t{fold_case(b)} << 8U) | trigram_t{fold_case(c)};
+}
+
+//! Append all trigrams of the text to `result`, without sorting or removing the duplicates
+inline void append_trigrams(std::string_view text, std::vector<trigram_t> &result) {
+   for (std::size_t i = 2; i < text.size(); ++i) {
+      result.push_back(make_trigram(text[i - 2], text[i - 1], text[i]));
+   }
+}
+
+inline void sort_unique(std::vector<trigram_t> &trigrams) {
+   std::sort(std::begin(trigrams), std::end(trigrams));
+   trigrams.erase(std::unique(std::begin(trigrams), std::end(trigrams)), std::end(trigrams));
+}
+
+//! @return Sorted unique trigrams of the text
+inline std::vector<trigram_t> text_trigrams(std::string_view text) {
+   std::vector<trigram_t> result;
+   append_trigrams(text, result);
+   sort_unique(result);
+   return result;
+}
+
+//! @return Sorted unique trigrams every text matching the LIKE pattern has to contain, empty if the pattern has no
+//!         literal parts long enough
+inline std::vector<trigram_t> like_pattern_trigrams(std::string_view pattern) {
+   std::vector<trigram_t> result;
+
+   std::size_t part_begin = 0;
+   for (std::size_t i = 0; i <= pattern.size(); ++i) {
+      if (i == pattern.size() || pattern[i] == '%' || pattern[i] == '_') {
+         append_trigrams(pattern.substr(part_begin, i - part_begin), result);
+         part_begin = i + 1;
+      }
+   }
+
+   sort_unique(result);
+   return result;
+}
+
+} // namespace ocs::common
@@ -31,6 +31,9 @@ public:
    void start() const;
 
    [[nodiscard]] std::optional<std::int64_t> frame_count() const;
+   [[nodiscard]] std::optional<std::chrono::milliseconds> duration() const;
+   [[nodiscard]] double frame_rate() const;
+   [[nodiscard]] std::pair<int, int> time_base() const;
 
    [[nodiscard]] std::chrono::seconds frame_number_to_seconds(std::int64_t num) const;
    [[nodiscard]] std::chrono::milliseconds frame_number_to_milliseconds(std::int64_t num) const;
@@ -10,6 +10,7 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 
 struct AVFrame;
@@ -51,6 +52,10 @@ public:
       int width;
       int height;
       int bytes_per_line;
+
+      //! Size of the video frame, differs from the size of the data if the frame was scaled down
+      int frame_width{0};
+      int frame_height{0};
    };
 
    enum class action { decode_next, stop };
@@ -70,15 +75,34 @@ public:
 public:
    void run() const;
 
+   //! Continue decoding from `frame_number`, the frames before it are skipped by the next `run`. A frame shortly
+   //! after the last decoded one is reached by decoding forward, without seeking back to its keyframe.
+   void seek(std::int64_t frame_number);
+
    [[nodiscard]] std::chrono::milliseconds frame_number_to_milliseconds(std::int64_t frame_number) const;
 
    [[nodiscard]] std::chrono::seconds frame_number_to_seconds(std::int64_t frame_number) const;
 
+   //! @return Average frame rate of the video stream
+   [[nodiscard]] double frame_rate() const;
+
+   //! @return Time base of the video stream, as a numerator and denominator pair
+   [[nodiscard]] std::pair<int, int> time_base() const;
+
+   //! @return Duration of the video file. Will return std::nullopt in case if video is not finalized yet.
+   [[nodiscard]] std::optional<std::chrono::milliseconds> duration() const;
+
    //! @return Total number of frames in the video file. Will return std::nullopt in case if video is not finalized yet.
    [[nodiscard]] std::optional<std::int64_t> frame_count() const { return frame_count_; }
 
    //! Convert a FFMPEG frame into our internal representation
-   void to_frame(const AVFrame &src, std::int64_t frame_number, frame &target) const;
+   //! @param max_width, max_height The frame is scaled down to fit into this size (keeping its aspect ratio), but
+   //!                              never scaled up. Not scaled if 0.
+   void to_frame(const AVFrame &src,
+                 std::int64_t frame_number,
+                 frame &target,
+                 int max_width = 0,
+                 int max_height = 0) const;
 
 private:
    [[nodiscard]] std::int64_t frame_number_to_timestamp(std::int64_t frame_number) const;
@@ -86,18 +110,30 @@ private:
    void hw_decoder_init() const;
 
    [[nodiscard]] bool seek_to_frame(std::int64_t frame_number) const;
+
+   //! @return true if the frame is in the same group of pictures as the last decoded one (or close enough to it, if
+   //!         the container has no index), and follows it
+   [[nodiscard]] bool can_decode_forward_to(std::int64_t frame_number) const;
    void seek_to_closest_frame(std::int64_t min_frame, std::int64_t max_frame, std::int64_t last_working);
 
    //! @return true if the decoding can continue, false otherwise
    bool handle_decoded_frames(const AVPacket *packet) const;
+   bool receive_decoded_frames() const;
 
-   void convert_to_rgb_and_copy_data(const AVFrame &src, std::vector<std::uint8_t> &target) const;
+   void convert_to_rgb_and_copy_data(const AVFrame &src,
+                                     int width,
+                                     int height,
+                                     std::vector<std::uint8_t> &target) const;
+
+private:
+   //! Maximal distance (in frames) decoded forward instead of seeking, when the keyframes positions are not known
+   static constexpr std::int64_t max_forward_decode = 60;
 
 private:
    const std::string path_;
    const frame_filter filter_;
    const frame_cb_t cb_;
-   const std::int64_t starting_frame_;
+   std::int64_t starting_frame_;
 
    //! FFMPEG-related fields
    std::unique_ptr<ffmpeg_data> ffmpeg_;
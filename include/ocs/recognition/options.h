@@ -48,6 +48,18 @@ struct options {
 
    //! Save bitmaps to disk
    bool save_bitmaps{false};
+
+   //! Maximal distance (in frames) between two appearances of the same text, for them to be stored as one span
+   std::int64_t span_gap{};
+
+   //! Maximal width and height of the stored frame thumbnails, no thumbnails are stored if zero
+   int thumbnail_size{0};
+
+   //! JPEG quality of the thumbnails (1 - 100)
+   int thumbnail_quality{75};
+
+   //! Store the thumbnails of all the processed frames, not only of the frames with any text
+   bool thumbnail_all_frames{false};
 };
 
 } // namespace ocs::recognition
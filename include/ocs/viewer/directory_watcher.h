@@ -0,0 +1,84 @@
+/**
+ * @file   directory_watcher.h
+ * @author Dennis Sitelew
+ * @date   Oct. 18, 2026
+ */
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace ocs::viewer {
+
+//! Watches a directory for the files with the given extension being added, changed or removed. The changes are
+//! reported by a background thread, at most once per interval, as the databases being written keep changing all the
+//! time.
+//!
+//! Uses inotify where it's available, otherwise the directory is listed every interval.
+class directory_watcher {
+public:
+   using changed_cb_t = std::function<void()>;
+
+public:
+   directory_watcher(std::string path, std::string extension, std::chrono::milliseconds interval, changed_cb_t cb);
+   ~directory_watcher();
+
+public:
+   directory_watcher(const directory_watcher &) = delete;
+   directory_watcher &operator=(const directory_watcher &) = delete;
+
+private:
+   struct file_state {
+      std::uint64_t size;
+      std::time_t mtime;
+      std::uint32_t change_counter;
+
+      bool operator==(const file_state &rhs) const {
+         return size == rhs.size && mtime == rhs.mtime && change_counter == rhs.change_counter;
+      }
+   };
+
+   using files_t = std::map<std::string, file_state>;
+
+private:
+   void thread_func();
+
+   //! @return true if any of the watched files was changed since the previous call
+   bool has_changes();
+
+   //! @return true if the directory is watched by inotify from now on, false if it has to be polled
+   bool start_notifications();
+
+   //! @return true if any of the pending notifications is about the watched files
+   bool read_notifications();
+
+   [[nodiscard]] bool is_watched(const std::string &file_name) const;
+   [[nodiscard]] files_t list_files() const;
+
+private:
+   std::string path_;
+   std::string extension_;
+   std::chrono::milliseconds interval_;
+   changed_cb_t cb_;
+
+   //! inotify instance, or -1 if the directory is polled
+   int notify_fd_{-1};
+
+   //! Files found by the last listing, only used while polling
+   files_t files_{};
+
+   std::mutex m_{};
+   std::condition_variable cv_{};
+   bool should_stop_{false};
+
+   std::thread thread_;
+};
+
+} // namespace ocs::viewer
@@ -0,0 +1,166 @@
+/**
+ * @file   frame_cache.h
+ * @author Dennis Sitelew
+ * @date   Oct. 18, 2026
+ */
+#pragma once
+
+#include <ocs/common/thumbnail.h>
+#include <ocs/ffmpeg/decoder.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ocs::viewer {
+
+//! Decoded (RGB) video frames, the least recently used ones are evicted. A background thread decodes the frames that
+//! are likely to be shown next, so that moving between the search results doesn't wait for the decoder.
+//!
+//! The decoders are kept open per video file, so the files are not reopened and probed for every frame. A decoder stays
+//! positioned after the last decoded frame, so stepping forward only decodes the frames in between.
+//!
+//! The thumbnails stored at ingest can be shown right away, while the full frame is decoded in the background.
+//!
+//! The frames can be decoded at the display resolution, those are cached separately from the full resolution ones.
+class frame_cache {
+public:
+   using frame_t = ffmpeg::decoder::frame;
+   using frame_ptr_t = std::shared_ptr<const frame_t>;
+
+   struct key {
+      std::string video_file;
+      std::int64_t frame_number;
+
+      //! The frame is scaled down to fit into this size, the full resolution frame is decoded if 0
+      int max_width{0};
+      int max_height{0};
+
+      bool operator==(const key &rhs) const {
+         return frame_number == rhs.frame_number && max_width == rhs.max_width && max_height == rhs.max_height &&
+                video_file == rhs.video_file;
+      }
+      bool operator!=(const key &rhs) const { return !(*this == rhs); }
+   };
+
+   //! A thumbnail of a frame, decoded
+   struct preview {
+      frame_t image;
+
+      //! Size of the full frame
+      int frame_width;
+      int frame_height;
+   };
+
+   //! @return Thumbnail of the frame stored at ingest, or std::nullopt if there is none
+   using thumbnail_source_t = std::function<std::optional<common::thumbnail>(const key &)>;
+
+public:
+   //! @param max_frames Maximal number of decoded frames kept in memory
+   //! @param thumbnail_source Provider of the thumbnails, the previews are not available if empty
+   explicit frame_cache(std::size_t max_frames, thumbnail_source_t thumbnail_source = {});
+   ~frame_cache();
+
+public:
+   frame_cache(const frame_cache &) = delete;
+   frame_cache &operator=(const frame_cache &) = delete;
+
+public:
+   //! @return The frame, decoded by the calling thread if it's not cached yet, or nullptr if it can't be decoded
+   frame_ptr_t get(const key &k);
+
+   //! @return The frame if it's decoded already (marking it as the most recently used one), or nullptr
+   frame_ptr_t find(const key &k);
+
+   //! Decode the frame in the background, before any of the prefetched frames
+   void request(const key &k);
+
+   //! @return true while the requested frame is waiting for (or being decoded by) the background thread
+   bool is_requested(const key &k);
+
+   //! Replace the frames waiting to be prefetched, the frames are decoded in the given order
+   void prefetch(std::vector<key> keys);
+
+   //! @return Decoded thumbnail of the frame, or std::nullopt if there is none
+   std::optional<preview> get_preview(const key &k) const;
+
+private:
+   //! Maximal number of video files kept open
+   static constexpr std::size_t max_open_decoders = 4;
+
+   struct key_hash {
+      std::size_t operator()(const key &k) const;
+   };
+
+   using frames_t = std::list<std::pair<key, frame_ptr_t>>;
+
+   struct open_decoder {
+      std::string video_file;
+
+      //! Guards the rest of the members, a single frame of the file is decoded at a time
+      std::mutex m{};
+
+      //! Opened by the first frame decoded from the file
+      std::unique_ptr<ffmpeg::decoder> decoder{};
+
+      //! Size the frame being decoded is scaled down to
+      int max_width{0};
+      int max_height{0};
+
+      //! Set by the decoder callback
+      std::optional<frame_t> decoded;
+   };
+
+private:
+   void thread_func();
+
+   void store(const key &k, const frame_ptr_t &frame);
+
+   frame_ptr_t decode(const key &k);
+
+   //! @return Decoder of the video file, not necessarily opened yet
+   std::shared_ptr<open_decoder> decoder_for(const std::string &video_file);
+
+   //! Open the decoder, or position it at the frame
+   //! @note The `d.m` has to be locked
+   static void seek(open_decoder &d, const key &k);
+
+private:
+   std::size_t max_frames_;
+   thumbnail_source_t thumbnail_source_;
+
+   //! Guards the frames and the prefetch queue
+   std::mutex m_{};
+   std::condition_variable cv_{};
+   bool should_stop_{false};
+
+   //! Most recently used first
+   frames_t frames_{};
+   std::unordered_map<key, frames_t::iterator, key_hash> by_key_{};
+
+   std::optional<key> requested_{};
+   std::deque<key> pending_{};
+
+   //! Frame being decoded by the background thread
+   std::optional<key> decoding_{};
+
+   //! Guards the list of the decoders. Each decoder is locked on its own, so that a frame shown from another file
+   //! doesn't wait for the one being prefetched.
+   std::mutex decoders_m_{};
+
+   //! Most recently used first. Note: an evicted decoder is closed once the frame being decoded by it is done.
+   std::list<std::shared_ptr<open_decoder>> decoders_{};
+
+   std::thread thread_;
+};
+
+} // namespace ocs::viewer
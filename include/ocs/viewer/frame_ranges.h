@@ -0,0 +1,32 @@
+/**
+ * @file   frame_ranges.h
+ * @author Dennis Sitelew
+ * @date   Oct. 18, 2026
+ */
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace ocs::viewer {
+
+//! Inclusive frame number ranges, sorted and not overlapping
+using frame_ranges_t = std::vector<std::pair<std::int64_t, std::int64_t>>;
+
+//! Set operations on the frame ranges, the query conditions are evaluated with. The whole range of std::int64_t is
+//! used, so the first and the last ranges might be unbounded.
+namespace frame_ranges {
+
+//! Merge the overlapping and adjacent ranges, the ranges have to be sorted by the first frame
+frame_ranges_t merge_sorted(const frame_ranges_t &ranges);
+
+frame_ranges_t intersect(const frame_ranges_t &lhs, const frame_ranges_t &rhs);
+frame_ranges_t unite(const frame_ranges_t &lhs, const frame_ranges_t &rhs);
+
+//! @return All the frames not in the ranges
+frame_ranges_t complement(const frame_ranges_t &ranges);
+
+} // namespace frame_ranges
+
+} // namespace ocs::viewer
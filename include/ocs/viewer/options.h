@@ -5,6 +5,7 @@
 #ifndef OCR_SUITE_VIEWER_OPTIONS_H
 #define OCR_SUITE_VIEWER_OPTIONS_H
 
+#include <cstddef>
 #include <optional>
 #include <string>
 
@@ -22,8 +23,36 @@ struct options {
    //! Database file extension
    std::string db_extension;
 
-   //! Store search results only in the RAM
-   bool in_memory_results{true};
+   //! Database the results of each finished search are exported to, the results are not exported if empty
+   std::string results_export_file;
+
+   //! Maximal number of idle database files kept open between searches
+   std::size_t max_open_databases{512};
+
+   //! Path to the search index file, the index is not used if empty
+   std::string index_file;
+
+   //! Archive database (created by `ocs-merge`) searched instead of the database files, if not empty
+   std::string archive_file;
+
+   //! Maximal number of search results kept in the cache of the recent queries, the cache is not used if zero
+   std::size_t query_cache_size{500'000};
+
+   //! Maximal number of decoded video frames kept in memory, including the prefetched ones
+   std::size_t frame_cache_size{16};
+
+   //! Fit the frames into the view, decoding them at the display resolution until zoomed into a text
+   bool preview_frames{false};
+
+   //! Redraw the window all the time, instead of only after the input or while something changes
+   bool redraw_continuously{false};
+
+   //! Maximal number of frames drawn per second, only limited by the vsync if 0
+   int max_fps{60};
+
+   //! Interval (in milliseconds) the video directory is checked for the new and changed database files, and the
+   //! current search is repeated if there are any. The directory is not watched if 0.
+   int watch_interval_ms{2000};
 };
 
 } // namespace ocs::viewer
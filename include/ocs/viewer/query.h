@@ -0,0 +1,110 @@
+/**
+ * @file   query.h
+ * @author Dennis Sitelew
+ * @date   Oct. 18, 2026
+ */
+#pragma once
+
+#include <ocs/common/database.h>
+#include <ocs/viewer/frame_ranges.h>
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ocs::viewer {
+
+//! A search query: LIKE patterns combined with AND, OR and NOT (evaluated per frame, i.e. "A AND B" finds the frames
+//! showing both texts), grouped with parentheses. A pattern spans all the words up to the next operator, so a text
+//! without any operators is a single pattern. Patterns containing keywords, parentheses or quotes have to be quoted,
+//! adjacent quoted patterns are implicitly AND-ed.
+//!
+//! Spatial conditions are attached to the patterns: "A NEAR/50 B" matches A and B visible at most 50 pixels apart,
+//! "A IN(1600,0,1920,200)" matches A overlapping the (left, top, right, bottom) region of the frame.
+//!
+//! "FUZZY/2 text" approximately matches the text, with up to 2 edits and ignoring the common OCR confusions (see
+//! fuzzy_match.h). The text is a plain string rather than a LIKE pattern.
+class query {
+public:
+   using entries_t = std::vector<ocs::common::database::search_entry>;
+
+   using frame_ranges_t = ocs::viewer::frame_ranges_t;
+
+public:
+   //! @throws std::invalid_argument if the query is malformed
+   static query parse(const std::string &text);
+
+public:
+   [[nodiscard]] const std::string &text() const { return text_; }
+   [[nodiscard]] const std::vector<std::string> &terms() const { return terms_; }
+
+   //! @return true if the term is used as a LIKE pattern, false if it's only searched approximately (FUZZY), so the
+   //!         exact text filters (trigram filter, search index) can't tell anything about it
+   [[nodiscard]] bool is_exact(std::size_t term) const;
+
+   //! @return true if the query is a single LIKE pattern, which can be passed to database::find_text directly
+   [[nodiscard]] bool is_single_pattern() const;
+
+   //! @return false if the query can't match, given whether each of the terms might be found
+   [[nodiscard]] bool may_match(const std::vector<bool> &term_may_match) const;
+
+   //! Find the spans of the (not negated) conditions, on the frames matching the whole query. The spans are clipped
+   //! to those frames.
+   void find(ocs::common::database &db, entries_t &entries) const;
+
+   //! Same as above, on the [min_frame, max_frame] frames only. The spans overlapping the range are looked at, and
+   //! clipped to it, so the ranges of a database can be searched independently.
+   void find(ocs::common::database &db, std::int64_t min_frame, std::int64_t max_frame, entries_t &entries) const;
+
+private:
+   //! A condition evaluated by the database: a pattern, possibly with a spatial constraint
+   struct leaf {
+      enum class kind { pattern, near, region, fuzzy };
+
+      kind type;
+      std::size_t term{0};
+
+      //! Second pattern of the `near` condition
+      std::size_t other_term{0};
+
+      //! Pixels for the `near` condition, edits for the `fuzzy` one
+      int max_distance{0};
+
+      ocs::common::database::region area{};
+   };
+
+   struct node {
+      enum class kind { leaf, and_op, or_op, not_op };
+
+      kind type;
+      std::size_t leaf{0};
+      std::size_t lhs{0};
+      std::size_t rhs{0};
+   };
+
+   class parser;
+
+private:
+   [[nodiscard]] frame_ranges_t evaluate(std::size_t idx, const std::vector<frame_ranges_t> &leaf_ranges) const;
+   void find(ocs::common::database &db,
+             const leaf &l,
+             std::int64_t min_frame,
+             std::int64_t max_frame,
+             entries_t &entries) const;
+   [[nodiscard]] bool may_match(std::size_t idx, const std::vector<bool> &term_may_match) const;
+
+private:
+   std::string text_{};
+
+   std::vector<node> nodes_{};
+   std::size_t root_{0};
+
+   std::vector<std::string> terms_{};
+   std::vector<leaf> leaves_{};
+
+   //! Conditions found somewhere not under a NOT, the spans of only those are returned
+   std::vector<bool> is_positive_{};
+};
+
+} // namespace ocs::viewer
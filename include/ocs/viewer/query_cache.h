@@ -0,0 +1,124 @@
+/**
+ * @file   query_cache.h
+ * @author Dennis Sitelew
+ * @date   Oct. 18, 2026
+ */
+#pragma once
+
+#include <ocs/common/database.h>
+#include <ocs/viewer/query.h>
+
+#include <cstdint>
+#include <ctime>
+#include <list>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ocs::viewer {
+
+//! Results of the recent searches, per searched part of each database file. The results of a file are only valid
+//! while the file is not changed, so a growing database is searched again, while the rest of the results are reused.
+//!
+//! A query refining a cached "%text%" one (e.g. "%text and more%") is answered by filtering the cached results.
+//!
+//! The results are stored together with the last frame stored in the database at the time it was searched, so that
+//! only the spans changed since have to be searched, when the database is still being written.
+class query_cache {
+public:
+   //! Properties of the database file the results were found in
+   struct file_state {
+      std::uint64_t size;
+      std::time_t mtime;
+
+      //! Incremented by every write, see `database::read_change_counter`
+      std::uint32_t change_counter;
+
+      bool operator==(const file_state &rhs) const {
+         return size == rhs.size && mtime == rhs.mtime && change_counter == rhs.change_counter;
+      }
+   };
+
+   struct value {
+      std::vector<ocs::common::database::search_entry> entries;
+      std::optional<ocs::common::database::video_info> video_info;
+   };
+
+   //! Results found in an older state of the file
+   struct stale_value {
+      value results;
+
+      //! Last frame stored in the database, when it was searched
+      std::int64_t high_water_mark;
+   };
+
+public:
+   //! @param max_entries Maximal number of spans kept in the cache, the least recently used queries are evicted
+   explicit query_cache(std::size_t max_entries);
+
+public:
+   //! @return Results of the query in the part of the database starting at `min_frame`, or std::nullopt if those
+   //!         are not cached for the file in this state
+   std::optional<value> find(const query &q,
+                             const std::string &database_path,
+                             std::int64_t min_frame,
+                             const file_state &state);
+
+   //! @return Results of exactly this query in the part of the database starting at `min_frame`, whatever the state
+   //!         of the file they were found in, or std::nullopt if there are none
+   std::optional<stale_value> find_stale(const query &q, const std::string &database_path, std::int64_t min_frame);
+
+   //! @param high_water_mark Last frame stored in the database when it was searched
+   void store(const query &q,
+              const std::string &database_path,
+              std::int64_t min_frame,
+              const file_state &state,
+              std::int64_t high_water_mark,
+              value results);
+
+private:
+   using item_key_t = std::pair<std::string, std::int64_t>;
+
+   struct cached_item {
+      file_state state;
+      std::int64_t high_water_mark;
+      value results;
+   };
+
+   struct cached_query {
+      std::string text;
+
+      //! The single LIKE pattern of the query, if it is one. The results of only those can be refined.
+      std::optional<std::string> pattern;
+
+      std::map<item_key_t, cached_item> items{};
+      std::size_t num_entries{0};
+   };
+
+   using queries_t = std::list<cached_query>;
+
+private:
+   //! @return Cost of the item in the cache, so that the empty results are not free
+   static std::size_t cost(const value &results) { return results.entries.size() + 1; }
+
+   //! Move the query to the front of the LRU list
+   void touch(queries_t::iterator it);
+
+   void evict(queries_t::iterator keep);
+
+private:
+   std::size_t max_entries_;
+
+   std::mutex m_{};
+
+   //! Most recently used first
+   queries_t queries_{};
+   std::unordered_map<std::string, queries_t::iterator> by_text_{};
+   std::size_t num_entries_{0};
+};
+
+} // namespace ocs::viewer
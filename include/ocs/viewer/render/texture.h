@@ -0,0 +1,60 @@
+/**
+ * @file   texture.h
+ * @author Dennis Sitelew
+ * @date   Oct. 18, 2026
+ */
+#ifndef INCLUDE_OCS_VIEWER_RENDER_TEXTURE_H
+#define INCLUDE_OCS_VIEWER_RENDER_TEXTURE_H
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace ocs::viewer::render {
+
+//! RGB texture, reused for the images shown one after another. The storage is only allocated again when the size of
+//! the image changes, otherwise the pixels are replaced in place.
+//!
+//! On OpenGL 3 and OpenGL ES 3 the pixels are streamed through two pixel buffers used in turns, so the upload returns
+//! as soon as the pixels are copied, and doesn't wait for the transfer of the previous image.
+class texture {
+public:
+   texture();
+   ~texture();
+
+public:
+   texture(const texture &) = delete;
+   texture &operator=(const texture &) = delete;
+
+public:
+   //! Replace the image, the `data` is `width` x `height` tightly packed RGB pixels
+   void update(const std::uint8_t *data, int width, int height);
+
+   [[nodiscard]] GLuint handle() const { return handle_; }
+   [[nodiscard]] int width() const { return width_; }
+   [[nodiscard]] int height() const { return height_; }
+
+private:
+   void allocate(int width, int height);
+
+   [[nodiscard]] std::size_t size() const { return static_cast<std::size_t>(width_) * height_ * 3; }
+
+   //! @return false if the pixel buffer can't be mapped, the pixels have to be uploaded directly in that case
+   bool upload_through_pixel_buffer(const std::uint8_t *data);
+
+private:
+   bool use_pixel_buffers_;
+
+   GLuint handle_{0};
+   int width_{0};
+   int height_{0};
+
+   std::array<GLuint, 2> pixel_buffers_{};
+   std::size_t next_pixel_buffer_{0};
+};
+
+} // namespace ocs::viewer::render
+
+#endif /* INCLUDE_OCS_VIEWER_RENDER_TEXTURE_H */
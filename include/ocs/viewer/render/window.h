@@ -10,6 +10,7 @@
 #include <SDL2/SDL.h>
 #include <imgui.h>
 
+#include <chrono>
 #include <functional>
 #include <string>
 
@@ -25,6 +26,15 @@ public:
       std::string title;
 
       ImVec4 background{0.45f, 0.55f, 0.60f, 1.00f};
+
+      //! Only redraw after the input events, or when a redraw was requested, otherwise wait for the events
+      bool wait_for_events{false};
+
+      //! Redraw at least this often while waiting for the events
+      std::chrono::milliseconds idle_timeout{1000};
+
+      //! Maximal number of frames drawn per second, only limited by the vsync if 0
+      int max_fps{0};
    };
 
    using draw_cb_t = std::function<void()>;
@@ -39,11 +49,23 @@ public:
 
    void set_title(const std::string &title);
 
+   //! Draw the next frame without waiting for the events, e.g. while something is animated or updated in the
+   //! background. Has to be requested again by every frame that still changes.
+   void request_redraw();
+
    static window &instance();
 
 private:
+   //! Number of frames drawn after an input event, ImGui might need a few frames to settle
+   static constexpr int frames_after_event = 3;
+
+private:
+   void handle_event();
    void draw() const;
 
+   //! Sleep for the rest of the frame time, if the frame rate is limited
+   void limit_frame_rate();
+
 private:
    options options_;
    draw_cb_t draw_cb_;
@@ -56,6 +78,10 @@ private:
    std::unique_ptr<render::frontend> frontend_;
 
    std::string title_{};
+
+   //! Number of frames to draw before waiting for the events again
+   int frames_to_draw_{frames_after_event};
+   std::chrono::steady_clock::time_point last_frame_{};
 };
 
 } // namespace ocs::viewer::render
@@ -8,14 +8,24 @@
 
 #include <sqlite-burrito/versioned_database.h>
 
+#include <cstdint>
 #include <mutex>
 #include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 struct sqlite3;
 
 namespace ocs::viewer {
 
-//! A class for storing the results of the OCR process in a sqlite3 database.
+//! Results of the current search, stored in memory column by column. The results of each file are sorted by the
+//! search thread storing them, those sorted runs are merged when the results are read in the timestamp order.
+//!
+//! The strings are interned by the search threads as well, each run has its own strings.
+//!
+//! The results can be exported to a sqlite3 database, once the search is finished.
 class results {
 private:
    static const int CURRENT_DB_VERSION;
@@ -26,6 +36,7 @@ public:
    struct entry {
       std::int64_t timestamp;
       std::int64_t frame;
+      std::int64_t last_frame;
       int left, top, right, bottom;
       float confidence;
       std::string text;
@@ -35,31 +46,117 @@ public:
    using optional_entry_t = std::optional<entry>;
 
 public:
-   explicit results(bool in_memory);
+   //! @param export_path Database the results are exported to, the results are not exported if empty
+   explicit results(std::string export_path);
 
 public:
-   void store(const search::search_entry &result);
-   void clear();
+   //! Store the results of a single file, may be called by multiple threads at once. The results of the searches
+   //! older than the last `clear` are ignored.
+   void store(const search::search_entry &result, std::uint64_t generation);
 
+   //! Drop all the results, the new ones are coming from the search `generation`
+   void clear(std::uint64_t generation);
+
+   //! Move the entries stored since the previous call (or since the last `clear`) into `entries`
+   void take_new_entries(std::vector<entry> &entries);
+
+   //! Start reading all the results stored so far, ordered by the timestamp
    void start_selection();
    optional_entry_t get_next();
 
+   //! Replace the content of the export database with the results of the search `generation`, if it's still the
+   //! current one
+   void export_results(std::uint64_t generation);
+
    static std::chrono::milliseconds start_time_for_video(const std::string &video_file);
 
+private:
+   //! Interned strings are referenced by their index
+   using string_id_t = std::uint32_t;
+
+   struct columns {
+      std::vector<std::int64_t> timestamps;
+      std::vector<std::int64_t> frames;
+      std::vector<std::int64_t> last_frames;
+      std::vector<std::int64_t> boxes;
+      std::vector<float> confidences;
+      std::vector<string_id_t> texts;
+      std::vector<string_id_t> video_files;
+
+      [[nodiscard]] std::size_t size() const { return timestamps.size(); }
+
+      void reserve(std::size_t size);
+      void clear();
+
+      //! Append the row `idx` of the other columns, its string ids are shifted by `string_offset`
+      void append(const columns &other, std::size_t idx, string_id_t string_offset);
+   };
+
+   //! Strings interned while a run is built, without locking
+   //! @note The capacity is reserved upfront, as the ids are looked up by the views of the strings
+   struct string_table {
+      std::vector<std::string> strings;
+      std::unordered_map<std::string_view, string_id_t> ids;
+
+      explicit string_table(std::size_t max_size) { strings.reserve(max_size); }
+
+      string_id_t intern(const std::string &value);
+   };
+
+   //! Rows [begin, end) sorted by the timestamp
+   struct run {
+      std::size_t begin;
+      std::size_t end;
+   };
+
+   //! Merge state of a single run
+   struct cursor {
+      std::int64_t timestamp;
+      std::size_t row;
+      std::size_t end;
+
+      bool operator>(const cursor &rhs) const { return timestamp > rhs.timestamp; }
+   };
+
 private:
    static void db_update(sqlite_burrito::versioned_database &con, int from, std::error_code &ec);
 
    void prepare_statements();
 
+   //! Start the k-way merge of the sorted runs
+   //! @note The `m_` has to be locked, for this and the following functions
+   void start_merge(std::vector<cursor> &cursors) const;
+
+   //! @return Next row in the timestamp order, or std::nullopt if all the runs are merged
+   std::optional<std::size_t> next_row(std::vector<cursor> &cursors) const;
+
+   [[nodiscard]] entry get_entry(std::size_t row);
+
 private:
    std::string db_path_;
    sqlite_burrito::versioned_database db_;
 
+   //! Guards the export database, the searches might be finishing in different threads
+   std::mutex export_m_{};
    statement_t add_text_entry_;
    statement_t clear_;
-   statement_t select_;
 
-   mutable std::recursive_mutex database_mutex_{};
+   //! Guards everything below
+   mutable std::mutex m_{};
+
+   std::uint64_t generation_{0};
+   columns columns_{};
+   std::vector<run> runs_{};
+
+   //! Strings of all the runs, the ones of different runs are not deduplicated
+   std::vector<std::string> strings_{};
+
+   //! Number of the rows already taken by `take_new_entries`
+   std::size_t num_taken_{0};
+
+   //! Runs being merged by `get_next`
+   std::uint64_t selection_generation_{0};
+   std::vector<cursor> selection_{};
 };
 
-} // namespace ocs
+} // namespace ocs::viewer
@@ -5,14 +5,22 @@
 #ifndef OCR_SUITE_VIEWER_SEARCH_H
 #define OCR_SUITE_VIEWER_SEARCH_H
 
+#include <ocs/common/archive.h>
 #include <ocs/common/database.h>
 #include <ocs/viewer/options.h>
+#include <ocs/viewer/query.h>
+#include <ocs/viewer/query_cache.h>
+#include <ocs/viewer/search_index.h>
 
+#include <atomic>
 #include <condition_variable>
+#include <ctime>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 namespace ocs::viewer {
@@ -22,27 +30,38 @@ class results;
 class search {
 public:
    using db_entries_t = std::vector<ocs::common::database::search_entry>;
+   using video_info_t = std::optional<ocs::common::database::video_info>;
 
    struct search_entry {
       std::string video_file_path;
       db_entries_t entries;
+
+      //! Video properties stored in the database, missing for the databases created by older versions
+      video_info_t video_info;
    };
 
-   class thread {
-   public:
-      struct database_file {
-         std::string database_path;
-         std::string video_path;
-         std::uint64_t size;
-      };
+   //! A part of a database file to be searched, large files are split into multiple first frame ranges
+   struct work_item {
+      std::string database_path;
+      std::string video_path;
+
+      std::int64_t min_frame;
+      std::int64_t max_frame;
+
+      //! Estimated cost of searching this item, in bytes
+      std::uint64_t size;
+   };
 
+   class thread {
    public:
       explicit thread(search &db);
       ~thread();
 
    public:
-      void run(const std::string &text);
-      void add_file(const database_file &file);
+      void run(const query &q, std::uint64_t generation);
+
+      //! Abort the query currently running on this thread, may be called from any thread
+      void interrupt();
 
    private:
       void start();
@@ -50,18 +69,45 @@ public:
 
    private:
       void thread_func();
-      void work_once();
+      void work_once(const query &q, std::uint64_t generation);
+
+      //! Run the query on a part of the database
+      //! @param stale Results of the previous search of the part, only the spans changed since are searched if set
+      void find(ocs::common::database &db,
+                const query &q,
+                const work_item &item,
+                const std::optional<query_cache::stale_value> &stale);
+
+      //! Run the query on all the videos of the archive at once
+      void find_archived(const query &q, const work_item &item, std::uint64_t generation);
+
+      //! @return true if the search was superseded by a newer one, or the thread is stopping
+      [[nodiscard]] bool is_cancelled(std::uint64_t generation) const;
+
+   private:
+      //! The frames are stored slightly out of order, and the spans still open can be extended by the frames stored
+      //! later. So the spans ending within the overlap before the previous high-water mark are searched again. The
+      //! overlap is derived from the span options recorded by the writer, this one is used for the databases written
+      //! before those were recorded.
+      static constexpr std::int64_t default_incremental_overlap = 1000;
 
    private:
       search *db_;
 
       std::mutex m_{};
-      std::string search_text_{};
+      query search_query_{};
+      std::uint64_t search_generation_{0};
       std::condition_variable cv_{};
       bool should_start_{false};
-      bool should_stop_{false};
-      std::vector<database_file> files_{};
+      std::atomic_bool should_stop_{false};
+
+      //! Database being searched right now, guarded by the `interrupt_m_`
+      std::mutex interrupt_m_{};
+      ocs::common::database *current_db_{nullptr};
+      ocs::common::archive *current_archive_{nullptr};
+
       db_entries_t current_entries_;
+      video_info_t current_video_info_;
 
       std::thread thread_;
    };
@@ -71,12 +117,79 @@ public:
    ~search();
 
 private:
-   void decrement_remaining_size(const thread::database_file &file, const db_entries_t &entries);
+   //! An open database, together with the file properties it was opened with
+   struct open_database {
+      std::unique_ptr<ocs::common::database> db;
+      std::uint64_t size;
+      std::time_t mtime;
+   };
+
+   //! Files found in the video directory
+   struct file_list {
+      std::vector<std::string> video_files{};
+      std::vector<std::string> database_files{};
+      std::vector<search_index::file_state> file_states{};
+
+      std::vector<work_item> work_items{};
+      std::uint64_t total_size{0};
+   };
+
+private:
+   //! @return Next item to be searched, or std::nullopt if there is nothing left to do for the given search
+   //! @param can_skip Set to true if the search index rules the item out for the current query
+   std::optional<work_item> get_next_item(std::uint64_t generation, bool &can_skip);
+
+   //! @return Cached results of the item, or std::nullopt if those have to be searched
+   //! @param state Set to the current state of the database file, if it could be read
+   std::optional<query_cache::value> find_cached(const query &q,
+                                                 const work_item &item,
+                                                 std::optional<query_cache::file_state> &state);
+
+   //! @return true if the database file wasn't changed since it was indexed
+   [[nodiscard]] bool is_indexed(const std::string &path) const;
+
+   void decrement_remaining_size(const work_item &item,
+                                 const db_entries_t &entries,
+                                 const video_info_t &video_info,
+                                 std::uint64_t generation);
+
+   //! @return An idle database from the pool, or a newly opened one if there is none, or if the file was changed
+   open_database acquire_database(const std::string &path);
+
+   //! Return the database to the pool, so that it can be reused by the next search
+   void release_database(const std::string &path, open_database db);
+
+   void add_work_items(const std::string &database_path,
+                       const std::string &video_path,
+                       std::uint64_t size,
+                       std::vector<work_item> &items) const;
+
+   [[nodiscard]] file_list list_files() const;
+
+   //! Start searching the files with the next search
+   //! @note The `m_` has to be locked
+   void use_files(file_list files);
+
+   //! Bring the index up to date with the files in the background, replacing the update still waiting (if any)
+   void update_index(std::vector<search_index::file_state> files);
+
+   void index_thread_func();
 
 public:
    void collect_files();
+
+   //! Collect the files again, e.g. after some were added or changed. The new list is used starting with the next
+   //! search, the one running (if any) is not affected. May be called from any thread.
+   void update_files();
+
+   //! Start a new search, cancelling the one still running (if any)
    void find_text(const std::string &text);
 
+   //! @return Thumbnail of the frame stored in the database, or std::nullopt if there is none. The database is taken
+   //!         from the pool of the open ones, so it's cheap enough for the UI thread. May be called from any thread.
+   //! @throws std::exception if the database can't be read
+   std::optional<ocs::common::thumbnail> get_thumbnail(const std::string &database_path, std::int64_t frame_number);
+
    [[nodiscard]] bool is_finished() const { return remaining_size_ == 0; }
 
    [[nodiscard]] double get_progress() const {
@@ -85,6 +198,9 @@ public:
 
    [[nodiscard]] results &get_results() const { return *results_; }
 
+   //! @return Number of the last search started, changes every time a new search is started
+   [[nodiscard]] std::uint64_t get_generation() const { return generation_.load(); }
+
 private:
    options options_;
 
@@ -92,13 +208,45 @@ private:
    std::vector<std::string> database_files_;
 
    std::mutex m_{};
-   std::uint64_t remaining_size_{};
+   std::atomic_uint64_t remaining_size_{};
    std::uint64_t total_size_{};
 
+   //! Shared work queue: items are sorted by their size (largest first), idle threads are taking the next one
+   std::vector<work_item> work_items_{};
+   std::size_t next_item_{0};
+
+   //! Files collected by `update_files`, waiting for the next search
+   std::optional<file_list> pending_files_{};
+
+   query query_{};
+
+   //! Files which may contain each of the query terms, according to the index (std::nullopt if all of them may)
+   std::vector<std::optional<search_index::paths_t>> candidates_{};
+   std::unique_ptr<search_index> index_{};
+
+   //! The index is updated by a background thread, the searches started before it's up to date search all the files
+   std::mutex index_m_{};
+   std::condition_variable index_cv_{};
+   std::optional<std::vector<search_index::file_state>> pending_index_files_{};
+   bool index_should_stop_{false};
+   std::atomic_bool index_ready_{false};
+   std::thread index_thread_{};
+
+   query_cache cache_;
+
+   //! Archive searched instead of the database files, if one was given
+   std::unique_ptr<ocs::common::archive> archive_{};
+
+   //! Databases kept open between the searches, shared by all the threads
+   std::mutex pool_m_{};
+   std::unordered_map<std::string, std::vector<open_database>> idle_databases_{};
+   std::size_t num_idle_databases_{0};
+
    std::vector<std::unique_ptr<thread>> threads_{};
    results *results_;
 
    std::chrono::steady_clock::time_point search_start_;
+   std::atomic_uint64_t generation_{0};
 };
 
 } // namespace ocs::viewer
@@ -0,0 +1,107 @@
+/**
+ * @file   search_index.h
+ * @author Dennis Sitelew
+ * @date   Oct. 18, 2026
+ */
+#pragma once
+
+#include <ocs/common/trigrams.h>
+
+#include <sqlite-burrito/versioned_database.h>
+
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace ocs::viewer {
+
+//! Trigram inverted index over the text entries of all the databases in the video directory, stored in a sidecar
+//! database. It is used to skip the databases which can't contain the searched text, without opening them.
+class search_index {
+private:
+   static const int CURRENT_DB_VERSION;
+
+   using statement_t = sqlite_burrito::statement;
+
+public:
+   struct file_state {
+      std::string path;
+      std::uint64_t size;
+      std::time_t mtime;
+
+      //! Incremented by every write, see `database::read_change_counter`
+      std::uint32_t change_counter;
+   };
+
+   using paths_t = std::unordered_set<std::string>;
+
+public:
+   explicit search_index(std::string db_path);
+
+public:
+   /**
+    * Index the new and changed files, and forget the ones not in the list anymore.
+    *
+    * The index stays usable while it's being updated: the lock is only held for one file at a time, and the files
+    * which are not indexed yet are not up to date.
+    *
+    * @param is_cancelled Checked between the files, the update stops early if it returns true
+    * @note Only one update may run at a time
+    */
+   void update(const std::vector<file_state> &files, const std::function<bool()> &is_cancelled = {});
+
+   //! @return Indexed files, which may contain a text matching the LIKE pattern, or std::nullopt if the pattern has
+   //!         no literal parts long enough to use the index
+   std::optional<paths_t> find_files(const std::string &pattern);
+
+   //! @return true if the file was indexed in exactly this state, i.e. the result of `find_files` is valid for it
+   bool is_up_to_date(const file_state &file) const;
+
+private:
+   //! A file, as it is stored in the index
+   struct indexed_file {
+      std::int64_t id;
+      std::uint64_t size;
+      std::time_t mtime;
+      std::uint32_t change_counter;
+      std::int64_t last_text_entry_id;
+
+      [[nodiscard]] bool is_in_state(const file_state &file) const {
+         return size == file.size && mtime == file.mtime && change_counter == file.change_counter;
+      }
+   };
+
+   using posting_t = std::pair<std::int64_t, std::int64_t>;
+
+private:
+   static void db_update(sqlite_burrito::versioned_database &con, int from, std::error_code &ec);
+
+   void prepare_statements();
+
+   void load_files();
+   void index_file(const file_state &file, indexed_file &indexed);
+   void get_postings(ocs::common::trigram_t trigram, std::vector<posting_t> &postings);
+
+private:
+   std::string db_path_;
+   sqlite_burrito::versioned_database db_;
+
+   statement_t get_files_;
+   statement_t add_file_;
+   statement_t update_file_;
+   statement_t remove_file_;
+   statement_t remove_orphaned_postings_;
+   statement_t add_posting_;
+   statement_t get_postings_;
+
+   mutable std::mutex database_mutex_{};
+   std::unordered_map<std::string, indexed_file> files_{};
+};
+
+} // namespace ocs::viewer
@@ -5,14 +5,17 @@
 #ifndef OCR_SUITE_FRAME_VIEW_H
 #define OCR_SUITE_FRAME_VIEW_H
 
+#include <ocs/viewer/frame_cache.h>
+#include <ocs/viewer/render/texture.h>
 #include <ocs/viewer/views/drawable.h>
 #include <ocs/viewer/views/search_results_view.h>
 
 #include <ocs/ffmpeg/decoder.h>
 
-#include <glad/glad.h>
 #include <imgui.h>
 
+#include <chrono>
+#include <memory>
 #include <optional>
 
 namespace ocs::viewer::views {
@@ -21,33 +24,60 @@ class frame_view final : public drawable {
 public:
    using frame_t = std::optional<search_results_view::frame>;
 
+private:
+   using clock_t = std::chrono::steady_clock;
+
+   //! The text boxes are pulsing for a while after the frame is shown, or a text is scrolled to
+   static constexpr auto highlight_duration = std::chrono::milliseconds{3000};
+   static constexpr auto highlight_period = std::chrono::milliseconds{400};
+
+   //! The size the frames are decoded at in the preview mode is a multiple of this step
+   static constexpr int view_size_step = 128;
+
 public:
-   explicit frame_view(search_results_view &search_results);
+   //! @param preview_frames Fit the frames into the view, decoding them at the display resolution. The full
+   //!                       resolution is only decoded when zooming into a text.
+   frame_view(search_results_view &search_results, frame_cache &frames, bool preview_frames);
 
 public:
    void set_current_frame(const frame_t &frame);
 
+   //! Update the current frame after the search results were changed, the frame is kept even if it's not part of the
+   //! results anymore, but jumping to the neighbour frames is not possible in that case
+   void relink_current_frame();
+
 public:
    void draw() override;
    [[nodiscard]] const char *name() const override { return "FrameView"; }
 
 private:
    void load_image_from_frame();
-   void make_texture(const ffmpeg::decoder::frame &decoded);
 
-   void scroll_to_text_entry(const search_results_view::text &entry) const;
+   //! Replace the image shown with the one wanted for the current zoom (and view size), once it's decoded. Until
+   //! then, the thumbnail or a frame decoded at another resolution is shown.
+   void update_image();
 
-   void jump_to_next_frame();
-   void jump_to_previous_frame();
+   //! @return Key of the frame at the resolution it's shown at
+   [[nodiscard]] frame_cache::key key_for(const search_results_view::frame &frame) const;
 
-   void jump_to_next_minute();
-   void jump_to_previous_minute();
+   //! @return true if the whole frame is fitted into the view (in the preview mode, unless zoomed in)
+   [[nodiscard]] bool is_fitted() const;
 
-   void jump_to_next_hour();
-   void jump_to_previous_hour();
+   //! @return Scale of the frame, relative to its full size
+   [[nodiscard]] float display_scale() const;
 
-   void jump_to_next_day();
-   void jump_to_previous_day();
+   //! @return Alpha of the text boxes, requests the next frame while those are pulsing
+   [[nodiscard]] int highlight_alpha() const;
+
+   //! Start decoding the frames reachable with a single jump from the current one
+   void prefetch_neighbours() const;
+   //! @param frame_width, frame_height Size of the full frame, the image might be smaller
+   void show_image(const ffmpeg::decoder::frame &decoded, int frame_width, int frame_height);
+
+   void scroll_to_text_entry(const search_results_view::text &entry) const;
+
+   //! Jump to the next (or previous) frame, minute, hour or day of the search results
+   void jump(search_results_view::level lvl, bool forward);
 
    void handle_scroll_to_text_hotkeys();
    void handle_jump_hotkeys();
@@ -57,10 +87,26 @@ private:
 private:
    frame_t current_frame_;
    search_results_view *search_results_view_;
+   frame_cache *frame_cache_;
+
+   //! Reused by all the frames, created once the window (and so the OpenGL context) exists
+   std::unique_ptr<render::texture> texture_{};
+   int frame_width_{0};
+   int frame_height_{0};
+
+   //! The texture holds an image of the current frame
+   bool has_image_{false};
+
+   //! Frame in the texture, std::nullopt if it holds the thumbnail
+   std::optional<frame_cache::key> loaded_key_{};
+   std::optional<frame_cache::key> requested_key_{};
+
+   bool preview_frames_;
+
+   //! The frame is shown in its full size, in the preview mode
+   bool zoomed_{false};
 
-   GLuint texture_handle_{0};
-   int texture_width_{0};
-   int texture_height_{0};
+   clock_t::time_point highlight_start_{};
 
    bool was_dragging_{false};
    ImVec2 initial_scroll_position_{};
@@ -5,9 +5,17 @@
 #ifndef OCR_SUITE_SEARCH_RESULTS_VIEW_H
 #define OCR_SUITE_SEARCH_RESULTS_VIEW_H
 
+#include <ocs/viewer/results.h>
 #include <ocs/viewer/search.h>
 #include <ocs/viewer/views/drawable.h>
 
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace ocs::viewer::views {
@@ -16,77 +24,133 @@ class frame_view;
 
 class search_results_view final : public drawable {
 public:
-   struct frame;
-   struct minute;
-   struct hour;
-   struct day;
+   //! Levels of the results tree, the frames are the leaves
+   enum class level { day, hour, minute, frame };
 
    struct text {
       int left, top, right, bottom;
       float confidence;
       std::string value;
-
-      frame *owner;
-      std::size_t owner_idx;
    };
 
+   //! A frame with all the texts found on it, copied out of the results
    struct frame {
-      std::string name;
       std::int64_t number;
+      std::int64_t last_number;
       std::int64_t timestamp;
       std::string video_file;
 
       std::vector<text> texts;
 
-      minute *owner;
-      std::size_t owner_idx;
+      //! Position of the frame in the results, std::nullopt if it's not part of the current results
+      std::optional<std::size_t> index;
    };
 
-   struct minute {
-      std::string name;
-      std::int64_t number;
-      std::vector<frame> frames;
+public:
+   search_results_view(search &srch, frame_view &frame_view);
 
-      hour *owner;
-      std::size_t owner_idx;
-   };
+public:
+   void draw() override;
+   [[nodiscard]] const char *name() const override { return "SearchResults"; }
 
-   struct hour {
-      std::string name;
-      std::int64_t number;
-      std::vector<minute> minutes;
+   [[nodiscard]] std::size_t num_frames() const { return tree_[frame_level].numbers.size(); }
+   [[nodiscard]] frame get_frame(std::size_t idx) const;
 
-      day *owner;
-      std::size_t owner_idx;
-   };
+   //! @return Index of the frame with the given timestamp, video file and frame number, or std::nullopt if there is
+   //!         no such frame
+   [[nodiscard]] std::optional<std::size_t> find_frame(std::int64_t timestamp,
+                                                       const std::string &video_file,
+                                                       std::int64_t number) const;
 
-   struct day {
-      std::string name;
-      std::int64_t number;
-      std::vector<hour> hours;
+   //! @return The first frame of the next node (or the last frame of the previous one) of the `lvl` level, relative
+   //!         to the frame `idx`. Stops at the first and the last frame of the results.
+   [[nodiscard]] std::size_t jump(std::size_t idx, level lvl, bool forward) const;
+
+   //! @return Date and time of the day (UTC) of the timestamp, e.g. "2023-01-22 10:15"
+   static std::string time_to_string(std::int64_t timestamp);
+
+private:
+   static constexpr auto frame_level = static_cast<std::size_t>(level::frame);
 
-      std::size_t owner_idx;
+   //! The new results are coalesced, and the tree is rebuilt at most this often while the search is running
+   static constexpr auto merge_interval = std::chrono::milliseconds{100};
+
+   using clock_t = std::chrono::steady_clock;
+
+   //! Interned strings are referenced by their index
+   using string_id_t = std::uint32_t;
+
+   //! A result entry, with the strings interned
+   struct entry {
+      std::int64_t timestamp;
+      std::int64_t frame;
+      std::int64_t last_frame;
+      int left, top, right, bottom;
+      float confidence;
+      string_id_t text;
+      string_id_t video_file;
    };
 
-public:
-   search_results_view(search &srch, frame_view &frame_view);
+   //! Nodes of a single level of the tree, in the display order. Node `i` has the children
+   //! [first_child[i], first_child[i + 1]) on the next level, the children of the frames are the result entries.
+   struct tree_level {
+      std::vector<std::int64_t> numbers{};
+      std::vector<std::size_t> parents{};
+      std::vector<std::size_t> first_child{};
 
-public:
-   void draw() override;
-   [[nodiscard]] const char *name() const override { return "SearchResults"; }
+      //! Keep only the first `size` nodes, removing the sentinel as well
+      void truncate(std::size_t size);
+   };
 
-   auto &get_days() { return days_; }
+   //! A visible line of the tree view
+   struct row {
+      level lvl;
+      std::size_t idx;
+   };
 
 private:
-   void sort_results();
+   //! Add the results found since the last call to the tree
+   void merge_new_results();
+
+   //! Rebuild the tree from the (sorted) entries, starting with the frame of the `first_entry`. The nodes of the
+   //! frames before it are kept, the entries of those must not have changed.
+   void build_tree(std::size_t first_entry);
+
+   string_id_t intern(const std::string &value);
+
+   //! Collect the rows of the expanded nodes
+   void update_rows();
+   void add_rows(level lvl, std::size_t first, std::size_t last);
+
+   void draw_row(const row &r);
+
+   //! @return Key identifying the node across the searches, used to keep the nodes expanded
+   [[nodiscard]] std::int64_t node_key(level lvl, std::size_t idx) const;
+   [[nodiscard]] bool is_open(level lvl, std::size_t idx) const;
 
 private:
    search *search_;
    frame_view *frame_view_;
 
-   bool is_finished_{true};
+   std::uint64_t generation_{0};
+   std::vector<results::entry> new_entries_{};
+
+   //! Results taken since the tree was built last time
+   std::vector<entry> pending_entries_{};
+   clock_t::time_point last_merge_{};
+
+   //! All the results, ordered by the frame (timestamp, video file, frame number)
+   std::vector<entry> entries_{};
+
+   //! Strings of the current results
+   std::vector<std::string> strings_{};
+   std::unordered_map<std::string, string_id_t> string_ids_{};
+
+   std::array<tree_level, frame_level + 1> tree_{};
 
-   std::vector<day> days_{};
+   std::array<std::unordered_set<std::int64_t>, frame_level> open_nodes_{};
+   std::vector<row> rows_{};
+   bool rows_changed_{false};
 };
 
 } // namespace ocs::viewer::views
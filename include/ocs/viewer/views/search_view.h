@@ -9,7 +9,9 @@
 
 #include <ocs/viewer/search.h>
 
+#include <chrono>
 #include <functional>
+#include <optional>
 #include <string>
 
 namespace ocs::viewer::views {
@@ -25,13 +27,25 @@ public:
    void set_text_change_cb(text_change_cb_t cb) { text_change_cb_ = std::move(cb); }
    void set_search_engine(search &db) { db_ = &db; }
 
+private:
+   using clock_t = std::chrono::steady_clock;
+
+   //! Time without typing, after which a search is started in the "as you type" mode
+   static constexpr auto typing_debounce = std::chrono::milliseconds{300};
+
+private:
+   //! Start searching the current text
+   //! @param explicit_request Set if the search was requested by the user, the same text is searched again then
+   void start_search(bool explicit_request);
+
 private:
    std::string search_text_;
    std::string last_search_text_;
    text_change_cb_t text_change_cb_;
    search *db_{};
 
-   std::string status_{};
+   bool search_as_you_type_{false};
+   std::optional<clock_t::time_point> last_edit_{};
 };
 
 } // namespace ocs::viewer::views
@@ -5,6 +5,8 @@
 #ifndef OCR_SUITE_VIEWER_H
 #define OCR_SUITE_VIEWER_H
 
+#include <ocs/viewer/directory_watcher.h>
+#include <ocs/viewer/frame_cache.h>
 #include <ocs/viewer/options.h>
 #include <ocs/viewer/search.h>
 #include <ocs/viewer/results.h>
@@ -15,6 +17,10 @@
 
 #include <ocs/viewer/render/window.h>
 
+#include <atomic>
+#include <memory>
+#include <string>
+
 namespace ocs::viewer::views {
 
 class viewer {
@@ -28,6 +34,9 @@ private:
    void draw();
    void search_text_changed(const std::string &text);
 
+   //! @return Thumbnail of the frame from the database of the video file
+   [[nodiscard]] std::optional<common::thumbnail> load_thumbnail(const frame_cache::key &k);
+
 private:
    options opts_;
 
@@ -36,9 +45,17 @@ private:
 
    std::unique_ptr<render::window> window_{};
 
+   frame_cache frame_cache_;
    frame_view frame_view_;
    search_view search_view_{};
    search_results_view search_results_view_;
+
+   //! Text of the last search, repeated when the files change
+   std::string search_text_{};
+   std::atomic_bool files_changed_{false};
+
+   //! Note: stopped before the search it's updating is destroyed
+   std::unique_ptr<directory_watcher> watcher_{};
 };
 
 } // namespace ocs::viewer::views
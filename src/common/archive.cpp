@@ -0,0 +1,257 @@
+/**
+ * @file   archive.cpp
+ * @author Dennis Sitelew
+ * @date   Oct. 18, 2026
+ */
+
+#include <ocs/common/archive.h>
+#include <ocs/common/packed_box.h>
+#include <ocs/common/timestamp.h>
+#include <ocs/ffmpeg/decoder.h>
+
+#include <spdlog/spdlog.h>
+#include <boost/filesystem.hpp>
+
+using namespace ocs::common;
+
+// Include updates implementations
+#define OCS_ARCHIVE_IDL_INCLUDE
+#include "archive/updates/v0.inl"
+
+// Note: should always be last
+#include "archive/updates/update.inl"
+#undef OCS_ARCHIVE_IDL_INCLUDE
+
+using open_flags_t = sqlite_burrito::connection::open_flags;
+using flags_t = sqlite_burrito::statement::prepare_flags;
+
+namespace fs = boost::filesystem;
+
+archive::archive(std::string db_path, bool read_only)
+   : read_only_{read_only}
+   , db_path_{std::move(db_path)}
+   , db_{read_only ? open_flags_t::readonly : open_flags_t::default_mode}
+   , get_video_{db_.get_connection(), flags_t::persistent}
+   , upsert_video_{db_.get_connection(), flags_t::persistent}
+   , find_text_{db_.get_connection(), flags_t::persistent} {
+   db_.open(db_path_, CURRENT_DB_VERSION, &archive::db_update);
+   prepare_statements();
+}
+
+double archive::probe_frame_rate(const std::string &video_path) {
+   if (!fs::exists(video_path)) {
+      spdlog::warn("Video file {} not found, frame rate is unknown", video_path);
+      return 0.0;
+   }
+
+   try {
+      const ffmpeg::decoder decoder{video_path, ffmpeg::decoder::frame_filter::all_frames,
+                                    [](const auto &, auto) { return ffmpeg::decoder::action::stop; }};
+      return decoder.frame_rate();
+   } catch (const std::exception &e) {
+      spdlog::warn("Error probing {}: {}", video_path, e.what());
+      return 0.0;
+   }
+}
+
+auto archive::merge(const std::string &db_path, const std::string &video_path) -> merge_result {
+   std::lock_guard lock{database_mutex_};
+
+   const auto source_size = static_cast<std::int64_t>(fs::file_size(db_path));
+   const auto source_mtime = static_cast<std::int64_t>(fs::last_write_time(db_path));
+   const auto source_change_counter = static_cast<std::int64_t>(database::read_change_counter(db_path));
+
+   auto &stmt = get_video_;
+   stmt.reset();
+   stmt.bind(":ppath", video_path);
+   if (stmt.step()) {
+      std::int64_t size, mtime, change_counter;
+      stmt.get(1, size);
+      stmt.get(2, mtime);
+      stmt.get(3, change_counter);
+      stmt.reset();
+
+      if (size == source_size && mtime == source_mtime && change_counter == source_change_counter) {
+         return merge_result::unchanged;
+      }
+   }
+
+   auto &con = db_.get_connection();
+
+   // Note: attaching and detaching is not possible inside a transaction
+   statement_t attach{con};
+   attach.prepare(R"sql(ATTACH DATABASE :ppath AS source;)sql");
+   attach.reset();
+   attach.bind(":ppath", db_path);
+   attach.execute();
+
+   auto detach = [&con]() { sqlite_burrito::statement::execute(con, "DETACH DATABASE source;"); };
+
+   // The source database is only read: it might be still written by the recognition, which is migrating it itself.
+   // So the databases with a different schema are not copied, those have to be migrated explicitly first.
+   int source_version{-1};
+   try {
+      statement_t get_version{con};
+      get_version.prepare(R"sql(SELECT version FROM source.metadata;)sql");
+      if (get_version.step()) {
+         get_version.get(0, source_version);
+      }
+      get_version.reset();
+   } catch (...) {
+      detach();
+      throw;
+   }
+
+   // Note: the version stored is the one of the last update applied
+   if (source_version + 1 != database::CURRENT_DB_VERSION) {
+      spdlog::debug("{} has the schema version {}, expected {}", db_path, source_version + 1,
+                    database::CURRENT_DB_VERSION);
+      detach();
+      return merge_result::outdated;
+   }
+
+   try {
+      // Note: opening a database with the current schema read-only doesn't change it
+      const auto video_info = database{db_path, true}.get_video_info();
+
+      // Only the databases created by older versions require probing the video file itself
+      auto start_time = timestamp::start_time_for_video(video_path).value_or(std::chrono::milliseconds{0});
+      double fps;
+      if (video_info) {
+         fps = video_info->frame_rate;
+         start_time = video_info->start_time.value_or(start_time);
+      } else {
+         fps = probe_frame_rate(video_path);
+      }
+
+      auto transaction = con.begin_transaction();
+
+      upsert_video_.reset();
+      upsert_video_.bind(":ppath", video_path);
+      upsert_video_.bind(":pstart", static_cast<std::int64_t>(start_time.count()));
+      upsert_video_.bind(":pfps", fps);
+      upsert_video_.bind(":psize", source_size);
+      upsert_video_.bind(":pmtime", source_mtime);
+      upsert_video_.bind(":pcounter", source_change_counter);
+      upsert_video_.execute();
+
+      stmt.reset();
+      stmt.bind(":ppath", video_path);
+      stmt.step();
+
+      std::int64_t video_id;
+      stmt.get(0, video_id);
+      stmt.reset();
+
+      // Statements referring to the attached database can only be prepared after attaching it
+      // clang-format off
+      statement_t remove_spans{con};
+      remove_spans.prepare(R"sql(DELETE FROM text_spans WHERE video_id = :pvid;)sql");
+
+      statement_t copy_entries{con};
+      copy_entries.prepare(R"sql(INSERT OR IGNORE INTO main.text_entries("value") SELECT value FROM source.text_entries;)sql");
+
+      statement_t copy_spans{con};
+      copy_spans.prepare(
+R"sql(INSERT INTO main.text_spans("video_id", "first_frame", "text_entry_id", "box", "last_frame", "confidence")
+      SELECT :pvid, s.first_frame, te.id, s.box, s.last_frame, s.confidence
+      FROM source.text_spans s
+      JOIN source.text_entries ste ON ste.id = s.text_entry_id
+      JOIN main.text_entries te ON te.value = ste.value
+      ORDER BY s.first_frame;)sql");
+      // clang-format on
+
+      remove_spans.reset();
+      remove_spans.bind(":pvid", video_id);
+      remove_spans.execute();
+
+      copy_entries.reset();
+      copy_entries.execute();
+
+      copy_spans.reset();
+      copy_spans.bind(":pvid", video_id);
+      copy_spans.execute();
+
+      transaction.commit();
+   } catch (...) {
+      detach();
+      throw;
+   }
+
+   detach();
+   return merge_result::merged;
+}
+
+void archive::find_text(const std::string &text, std::vector<video_entries> &results) {
+   std::lock_guard lock{database_mutex_};
+
+   auto &stmt = find_text_;
+   stmt.reset();
+   stmt.bind(":ptext", text);
+
+   std::int64_t current_video_id{-1};
+   while (stmt.step()) {
+      std::int64_t video_id;
+      stmt.get(0, video_id);
+
+      if (video_id != current_video_id) {
+         current_video_id = video_id;
+
+         std::int64_t start_time;
+         auto &video = results.emplace_back();
+         stmt.get(1, video.video_path);
+         stmt.get(2, start_time);
+         stmt.get(3, video.frame_rate);
+         video.start_time = std::chrono::milliseconds{start_time};
+      }
+
+      std::int64_t box;
+      int confidence;
+      auto &entry = results.back().entries.emplace_back();
+      stmt.get(4, entry.frame_number);
+      stmt.get(5, entry.last_frame_number);
+      stmt.get(6, box);
+      stmt.get(7, confidence);
+      stmt.get(8, entry.text);
+
+      const auto unpacked = unpack_box(box);
+      entry.left = unpacked.left;
+      entry.top = unpacked.top;
+      entry.right = unpacked.right;
+      entry.bottom = unpacked.bottom;
+      entry.confidence = dequantize_confidence(confidence);
+   }
+
+   stmt.reset();
+}
+
+void archive::interrupt() {
+   // Note: no locking, the query being interrupted is holding the lock
+   sqlite3_interrupt(db_.get_connection().get_handle());
+}
+
+void archive::prepare_statements() {
+   // clang-format off
+   get_video_.prepare(
+R"sql(SELECT id, source_size, source_mtime, source_change_counter FROM videos WHERE path = :ppath;)sql");
+
+   if (!read_only_) {
+      upsert_video_.prepare(
+R"sql(INSERT INTO videos("path", "start_time", "fps", "source_size", "source_mtime", "source_change_counter")
+      VALUES (:ppath, :pstart, :pfps, :psize, :pmtime, :pcounter)
+      ON CONFLICT(path) DO UPDATE SET start_time=excluded.start_time, fps=excluded.fps,
+                                      source_size=excluded.source_size, source_mtime=excluded.source_mtime,
+                                      source_change_counter=excluded.source_change_counter;)sql");
+   }
+
+   // Note: the matching texts are looked up first, then only their spans are read
+   find_text_.prepare(
+R"sql(SELECT v.id, v.path, v.start_time, v.fps, s.first_frame, s.last_frame, s.box, s.confidence, te.value
+      FROM text_entries te
+      CROSS JOIN text_spans s ON s.text_entry_id = te.id
+      JOIN videos v ON v.id = s.video_id
+      WHERE te.value LIKE :ptext
+      ORDER BY v.id, s.first_frame;)sql");
+
+   // clang-format on
+}
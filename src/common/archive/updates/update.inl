@@ -0,0 +1,22 @@
+//
+// Created by Dennis Sitelew on 18.10.26.
+//
+
+#ifndef OCS_ARCHIVE_IDL_INCLUDE
+#error Internal use only
+#endif
+
+const int archive::CURRENT_DB_VERSION = 1;
+
+inline void archive::db_update(sqlite_burrito::versioned_database &con, int from, std::error_code &ec) {
+   spdlog::trace("Updating archive: from version {}", from);
+
+   switch (from) {
+      case 0:
+         update_v0(con, ec);
+         return;
+
+      default:
+         ec = std::make_error_code(std::errc::invalid_argument);
+   }
+}
@@ -0,0 +1,62 @@
+//
+// Created by Dennis Sitelew on 18.10.26.
+//
+
+#ifndef OCS_ARCHIVE_IDL_INCLUDE
+#error Internal use only
+#endif
+
+namespace {
+
+void update_v0(sqlite_burrito::versioned_database &db, std::error_code &ec) {
+   // Note: the spans are using the same compact layout as the OCR databases, so those are copied as they are
+   const auto sql = R"sql(
+BEGIN TRANSACTION;
+
+CREATE TABLE metadata(version INT);
+INSERT INTO  metadata(version) VALUES (0);
+
+CREATE TABLE videos (
+   id INTEGER PRIMARY KEY AUTOINCREMENT NOT NULL,
+   "path" TEXT UNIQUE NOT NULL,
+   "start_time" INT NOT NULL,
+   "fps" FLOAT NOT NULL,
+   "source_size" INT NOT NULL,
+   "source_mtime" INT NOT NULL,
+   "source_change_counter" INT NOT NULL
+);
+
+CREATE TABLE text_entries (
+   id INTEGER PRIMARY KEY AUTOINCREMENT NOT NULL,
+   "value" TEXT UNIQUE NOT NULL
+);
+
+CREATE TABLE text_spans (
+   video_id INTEGER NOT NULL,
+   "first_frame" INT NOT NULL,
+   text_entry_id INTEGER NOT NULL,
+   "box" INT NOT NULL,
+   "last_frame" INT NOT NULL,
+   "confidence" INT NOT NULL,
+
+   PRIMARY KEY(video_id, first_frame, text_entry_id, box),
+
+   FOREIGN KEY(video_id)
+      REFERENCES videos(id)
+      ON UPDATE CASCADE
+      ON DELETE CASCADE,
+
+   FOREIGN KEY(text_entry_id)
+      REFERENCES text_entries(id)
+      ON UPDATE CASCADE
+      ON DELETE CASCADE
+) WITHOUT ROWID;
+
+CREATE INDEX text_spans_text_entry_idx ON text_spans(text_entry_id);
+
+COMMIT;
+)sql";
+   sqlite_burrito::statement::execute(db.get_connection(), sql, ec);
+}
+
+} // namespace
@@ -3,18 +3,36 @@
 //
 
 #include <ocs/common/database.h>
+#include <ocs/common/packed_box.h>
+#include <ocs/common/trigram_filter.h>
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+
 using namespace ocs::common;
 
 // Include updates implementations. Those functions are usually very big and not that interesting, so they are
 // implemented in standalone modules
 #define OCS_IDL_INCLUDE
+#include "db/updates/chunked_step.inl"
+
 #include "db/updates/v0.inl"
 #include "db/updates/v1.inl"
 #include "db/updates/v2.inl"
 #include "db/updates/v3.inl"
+#include "db/updates/v4.inl"
+#include "db/updates/v5.inl"
+#include "db/updates/v6.inl"
+#include "db/updates/v7.inl"
+#include "db/updates/v8.inl"
+#include "db/updates/v9.inl"
+#include "db/updates/v10.inl"
+#include "db/updates/v11.inl"
 
 // Note: should always be last
 #include "db/updates/update.inl"
@@ -25,10 +43,49 @@ using flags_t = sqlite_burrito::statement::prepare_flags;
 
 namespace {
 
+//! The databases might be searched while they are still being written, so a connection waits this long for the
+//! other ones to release the file, instead of failing right away
+const int busy_timeout_ms = 10'000;
+
 void sqlite3_error_callback(void *pArg, int iErrCode, const char *zMsg) {
+   // Cancelled searches are interrupted on purpose, and the statements outdated by a schema change are prepared again
+   // by SQLite itself, so neither of those is an error
+   const auto primary_code = iErrCode & 0xff;
+   if (primary_code == SQLITE_INTERRUPT || primary_code == SQLITE_SCHEMA) {
+      spdlog::trace("SQLite3: {} [{}]", zMsg, iErrCode);
+      return;
+   }
+
    spdlog::error("SQLite3 error: {} [{}]", zMsg, iErrCode);
 }
 
+//! sqlite3_config is not thread-safe, and it fails once the library was initialized by the first connection. So the
+//! log is configured once, while the static objects are initialized, before any connection is opened.
+struct sqlite3_log_config {
+   sqlite3_log_config() { sqlite3_config(SQLITE_CONFIG_LOG, sqlite3_error_callback, nullptr); }
+};
+
+const sqlite3_log_config configure_sqlite3_log{};
+
+//! Read a span from the columns (first_frame, last_frame, box, confidence, value), starting at `col`
+void read_search_entry(sqlite_burrito::statement &stmt, int col, database::search_entry &entry) {
+   std::int64_t box;
+   int confidence;
+
+   stmt.get(col, entry.frame_number);
+   stmt.get(col + 1, entry.last_frame_number);
+   stmt.get(col + 2, box);
+   stmt.get(col + 3, confidence);
+   stmt.get(col + 4, entry.text);
+
+   const auto unpacked = unpack_box(box);
+   entry.left = unpacked.left;
+   entry.top = unpacked.top;
+   entry.right = unpacked.right;
+   entry.bottom = unpacked.bottom;
+   entry.confidence = dequantize_confidence(confidence);
+}
+
 } // namespace
 
 database::database(std::string db_path, bool read_only)
@@ -37,25 +94,57 @@ database::database(std::string db_path, bool read_only)
    , db_{read_only ? open_flags_t::readonly : open_flags_t::default_mode}
    , add_text_entry_{db_.get_connection(), flags_t::persistent}
    , get_text_entry_id_{db_.get_connection(), flags_t::persistent}
-   , add_text_instance_{db_.get_connection(), flags_t::persistent}
+   , add_text_span_{db_.get_connection(), flags_t::persistent}
+   , update_text_span_{db_.get_connection(), flags_t::persistent}
+   , remove_text_span_{db_.get_connection(), flags_t::persistent}
+   , get_open_spans_{db_.get_connection(), flags_t::persistent}
    , get_starting_frame_number_{db_.get_connection(), flags_t::persistent}
-   , is_frame_number_present_{db_.get_connection(), flags_t::persistent}
    , store_last_frame_number_{db_.get_connection(), flags_t::persistent}
-   , find_text_{db_.get_connection(), flags_t::persistent} {
-   sqlite3_config(SQLITE_CONFIG_LOG, sqlite3_error_callback, nullptr);
+   , find_text_{db_.get_connection(), flags_t::persistent}
+   , find_text_crossing_{db_.get_connection(), flags_t::persistent}
+   , find_text_in_region_{db_.get_connection(), flags_t::persistent}
+   , find_text_near_{db_.get_connection(), flags_t::persistent}
+   , get_text_spans_{db_.get_connection(), flags_t::persistent}
+   , get_text_entries_{db_.get_connection(), flags_t::persistent}
+   , add_trigram_filter_bits_{db_.get_connection(), flags_t::persistent}
+   , get_trigram_filter_word_{db_.get_connection(), flags_t::persistent}
+   , store_video_info_{db_.get_connection(), flags_t::persistent}
+   , get_video_info_{db_.get_connection(), flags_t::persistent}
+   , store_span_options_{db_.get_connection(), flags_t::persistent}
+   , get_span_options_{db_.get_connection(), flags_t::persistent}
+   , add_thumbnail_{db_.get_connection(), flags_t::persistent}
+   , get_thumbnail_{db_.get_connection(), flags_t::persistent} {
    db_.open(db_path_, CURRENT_DB_VERSION, &database::db_update);
+   sqlite3_busy_timeout(db_.get_connection().get_handle(), busy_timeout_ms);
+
    prepare_statements();
+
+   if (!read_only_) {
+      resume_frame_ = get_starting_frame_number() - 1;
+      last_frame_number_ = resume_frame_;
+   }
 }
 
 void database::store(const common::ocr_result &result) {
-   store_last_frame_number(result.frame_number);
-   if (result.entries.empty()) {
+   std::lock_guard lock{database_mutex_};
+
+   // Storing a frame again would add its texts to new spans, if the spans it was added to are not open anymore
+   if (is_frame_processed(result.frame_number)) {
       return;
    }
 
-   std::lock_guard lock{database_mutex_};
+   if (!open_spans_loaded_) {
+      load_open_spans();
+   }
 
-   if (is_frame_processed(result.frame_number)) {
+   max_stored_frame_ = std::max(max_stored_frame_, result.frame_number);
+
+   if (result.entries.empty()) {
+      if (result.preview) {
+         add_thumbnail(result.preview.value());
+      }
+      store_last_frame_number(result.frame_number);
+      close_stale_spans();
       return;
    }
 
@@ -64,6 +153,11 @@ void database::store(const common::ocr_result &result) {
       stmt.reset();
       stmt.bind(":pvalue", text);
       stmt.execute();
+
+      // A new text, the filter is updated in the same transaction
+      if (sqlite3_changes(db_.get_connection().get_handle()) > 0) {
+         add_to_trigram_filter(text);
+      }
    };
 
    auto get_text_entry_id = [&](const std::string &text) {
@@ -77,34 +171,226 @@ void database::store(const common::ocr_result &result) {
       return entry_id;
    };
 
-   auto &stmt = add_text_instance_;
-
    try {
       auto transaction = db_.get_connection().begin_transaction();
 
       for (const auto &entry : result.entries) {
          add_text_entry(entry.text);
-         auto text_id = get_text_entry_id(entry.text);
+         const auto text_id = get_text_entry_id(entry.text);
 
-         stmt.reset();
-         stmt.bind(":ptid", text_id);
-         stmt.bind(":pnum", result.frame_number);
-         stmt.bind(":pleft", entry.left);
-         stmt.bind(":ptop", entry.top);
-         stmt.bind(":pright", entry.right);
-         stmt.bind(":pbottom", entry.bottom);
-         stmt.bind(":pconfidence", entry.confidence);
-         stmt.execute();
+         add_to_span(text_id, result.frame_number, entry);
       }
 
+      if (result.preview) {
+         add_thumbnail(result.preview.value());
+      }
+
+      // Note: in the same transaction, so that the frame is never marked processed without its texts
+      store_last_frame_number(result.frame_number);
+
       transaction.commit();
    } catch (const std::exception &e) {
       spdlog::error("Failed to store OCR result for frame {}, {}", result.frame_number, e.what());
+      open_spans_loaded_ = false;
       throw;
    } catch (...) {
       spdlog::error("Failed to store OCR result for frame {}", result.frame_number);
+      open_spans_loaded_ = false;
       throw;
    }
+
+   close_stale_spans();
+}
+
+void database::add_to_span(std::int64_t text_id, std::int64_t frame_num, const text_entry &entry) {
+   const auto &opts = span_options_;
+
+   auto is_same_box = [&](const open_span &span) {
+      return std::abs(span.left - entry.left) <= opts.max_box_delta &&
+             std::abs(span.top - entry.top) <= opts.max_box_delta &&
+             std::abs(span.right - entry.right) <= opts.max_box_delta &&
+             std::abs(span.bottom - entry.bottom) <= opts.max_box_delta;
+   };
+
+   auto is_close_enough = [&](const open_span &span) {
+      return frame_num >= (span.first_frame - opts.max_frame_gap) && frame_num <= (span.last_frame + opts.max_frame_gap);
+   };
+
+   const auto confidence = quantize_confidence(entry.confidence);
+
+   auto &candidates = open_spans_[text_id];
+   for (auto &span : candidates) {
+      if (!is_same_box(span) || !is_close_enough(span)) {
+         continue;
+      }
+
+      const auto first_frame = std::min(span.first_frame, frame_num);
+      auto last_frame = std::max(span.last_frame, frame_num);
+      auto max_confidence = std::max(span.confidence, confidence);
+      if (first_frame == span.first_frame && last_frame == span.last_frame && max_confidence == span.confidence) {
+         // Frame is already covered by the span
+         return;
+      }
+
+      // Moving the first frame might collide with another span of the same text and box, starting at that frame. That
+      // span is merged into this one then.
+      const bool has_collision = first_frame != span.first_frame && remove_text_span(text_id, first_frame, span.box,
+                                                                                      last_frame, max_confidence);
+
+      auto &stmt = update_text_span_;
+      stmt.reset();
+      stmt.bind(":ptid", text_id);
+      stmt.bind(":pbox", span.box);
+      stmt.bind(":pold_first", span.first_frame);
+      stmt.bind(":pfirst", first_frame);
+      stmt.bind(":plast", last_frame);
+      stmt.bind(":pconfidence", max_confidence);
+      stmt.execute();
+
+      span.first_frame = first_frame;
+      span.last_frame = last_frame;
+      span.confidence = max_confidence;
+
+      if (has_collision) {
+         const auto *merged = &span;
+         const auto box = span.box;
+         candidates.erase(std::remove_if(std::begin(candidates), std::end(candidates),
+                                         [&](const open_span &other) {
+                                            return &other != merged && other.first_frame == first_frame &&
+                                                   other.box == box;
+                                         }),
+                          std::end(candidates));
+      }
+      return;
+   }
+
+   open_span span{};
+   span.first_frame = frame_num;
+   span.last_frame = frame_num;
+   span.box = pack_box(entry.left, entry.top, entry.right, entry.bottom);
+   span.left = entry.left;
+   span.top = entry.top;
+   span.right = entry.right;
+   span.bottom = entry.bottom;
+   span.confidence = confidence;
+
+   auto &stmt = add_text_span_;
+   stmt.reset();
+   stmt.bind(":ptid", text_id);
+   stmt.bind(":pbox", span.box);
+   stmt.bind(":pfirst", span.first_frame);
+   stmt.bind(":plast", span.last_frame);
+   stmt.bind(":pconfidence", span.confidence);
+   stmt.execute();
+
+   candidates.push_back(span);
+}
+
+bool database::remove_text_span(std::int64_t text_id,
+                                std::int64_t first_frame,
+                                std::int64_t box,
+                                std::int64_t &last_frame,
+                                int &confidence) {
+   auto &stmt = remove_text_span_;
+   stmt.reset();
+   stmt.bind(":ptid", text_id);
+   stmt.bind(":pbox", box);
+   stmt.bind(":pfirst", first_frame);
+
+   bool removed = false;
+   while (stmt.step()) {
+      std::int64_t removed_last_frame;
+      int removed_confidence;
+      stmt.get(0, removed_last_frame);
+      stmt.get(1, removed_confidence);
+
+      last_frame = std::max(last_frame, removed_last_frame);
+      confidence = std::max(confidence, removed_confidence);
+      removed = true;
+   }
+
+   stmt.reset();
+   return removed;
+}
+
+void database::load_open_spans() {
+   open_spans_.clear();
+
+   auto &stmt = get_open_spans_;
+   stmt.reset();
+   stmt.bind(":pmin", get_starting_frame_number() - 1 - span_options_.max_frame_gap);
+
+   while (stmt.step()) {
+      std::int64_t text_id;
+      open_span span{};
+      stmt.get(0, text_id);
+      stmt.get(1, span.first_frame);
+      stmt.get(2, span.last_frame);
+      stmt.get(3, span.box);
+      stmt.get(4, span.confidence);
+
+      const auto box = unpack_box(span.box);
+      span.left = box.left;
+      span.top = box.top;
+      span.right = box.right;
+      span.bottom = box.bottom;
+
+      open_spans_[text_id].push_back(span);
+   }
+
+   open_spans_loaded_ = true;
+}
+
+void database::close_stale_spans() {
+   const auto min_last_frame = max_stored_frame_ - span_options_.open_span_frames();
+
+   for (auto it = open_spans_.begin(); it != open_spans_.end();) {
+      auto &spans = it->second;
+      spans.erase(std::remove_if(std::begin(spans), std::end(spans),
+                                 [&](const auto &span) { return span.last_frame < min_last_frame; }),
+                  std::end(spans));
+
+      if (spans.empty()) {
+         it = open_spans_.erase(it);
+      } else {
+         ++it;
+      }
+   }
+}
+
+void database::set_span_options(const span_options &opts) {
+   std::lock_guard lock{database_mutex_};
+   span_options_ = opts;
+   open_spans_loaded_ = false;
+
+   if (read_only_) {
+      return;
+   }
+
+   auto &stmt = store_span_options_;
+   stmt.reset();
+   stmt.bind(":pgap", opts.max_frame_gap);
+   stmt.bind(":pwindow", opts.open_span_frames());
+   stmt.execute();
+}
+
+auto database::get_span_overlap() -> std::optional<std::int64_t> {
+   std::lock_guard lock{database_mutex_};
+
+   auto &stmt = get_span_options_;
+   stmt.reset();
+   if (!stmt.step() || stmt.is_null(0) || stmt.is_null(1)) {
+      stmt.reset();
+      return std::nullopt;
+   }
+
+   std::int64_t max_frame_gap, open_span_frames;
+   stmt.get(0, max_frame_gap);
+   stmt.get(1, open_span_frames);
+   stmt.reset();
+
+   // A frame arriving late, but still within the open window, extends the spans ending up to the gap before it
+   return open_span_frames + max_frame_gap;
 }
 
 auto database::get_starting_frame_number() -> std::int64_t {
@@ -116,27 +402,21 @@ auto database::get_starting_frame_number() -> std::int64_t {
 
    std::int64_t result;
    stmt.get(0, result);
+
+   // Note: a statement left in progress keeps the read transaction open, blocking the writer
+   stmt.reset();
    return result + 1;
 }
 
 bool database::is_frame_processed(std::int64_t frame_num) {
    std::lock_guard lock{database_mutex_};
-   auto &stmt = is_frame_number_present_;
-
-   stmt.reset();
-   stmt.bind(":pnum", frame_num);
-   stmt.step();
-
-   bool result;
-   stmt.get(0, result);
-   return result;
+   return frame_num <= resume_frame_;
 }
 
 void database::store_last_frame_number(std::int64_t frame_num) {
    std::lock_guard lock{database_mutex_};
 
-   static std::int64_t max_frame_number = -1;
-   if (frame_num <= max_frame_number) {
+   if (frame_num <= last_frame_number_) {
       return;
    }
 
@@ -146,27 +426,352 @@ void database::store_last_frame_number(std::int64_t frame_num) {
    stmt.bind(":pnum", frame_num);
    stmt.execute();
 
-   max_frame_number = frame_num;
+   last_frame_number_ = frame_num;
 }
 
 void database::find_text(const std::string &text, std::vector<search_entry> &entries) {
+   using limits = std::numeric_limits<std::int64_t>;
+   find_text(text, limits::min(), limits::max(), entries);
+}
+
+void database::find_text(const std::string &text,
+                         std::int64_t min_frame,
+                         std::int64_t max_frame,
+                         std::vector<search_entry> &entries) {
+   using limits = std::numeric_limits<std::int64_t>;
+   find_text(text, min_frame, max_frame, limits::min(), entries);
+}
+
+void database::find_text(const std::string &text,
+                         std::int64_t min_frame,
+                         std::int64_t max_frame,
+                         std::int64_t min_last_frame,
+                         std::vector<search_entry> &entries) {
    entries.clear();
 
    auto &stmt = find_text_;
    stmt.reset();
    stmt.bind(":ptext", text);
+   stmt.bind(":pmin", min_frame);
+   stmt.bind(":pmax", max_frame);
+   stmt.bind(":plast", min_last_frame);
+
+   while (stmt.step()) {
+      read_search_entry(stmt, 0, entries.emplace_back());
+   }
+}
+
+void database::find_text_overlapping(const std::string &text,
+                                     std::int64_t min_frame,
+                                     std::int64_t max_frame,
+                                     std::vector<search_entry> &entries) {
+   find_text(text, min_frame, max_frame, entries);
+
+   if (min_frame == std::numeric_limits<std::int64_t>::min()) {
+      return;
+   }
+
+   // The spans are clustered by their first frame, the ones started before the range are found by the R*Tree instead
+   auto &stmt = find_text_crossing_;
+   stmt.reset();
+   stmt.bind(":ptext", text);
+   stmt.bind(":pframe", min_frame);
+
+   while (stmt.step()) {
+      read_search_entry(stmt, 0, entries.emplace_back());
+   }
+}
+
+void database::find_text_in_region(const std::string &text, const region &area, std::vector<search_entry> &entries) {
+   using limits = std::numeric_limits<std::int64_t>;
+   find_text_in_region(text, area, limits::min(), limits::max(), entries);
+}
+
+void database::find_text_in_region(const std::string &text,
+                                   const region &area,
+                                   std::int64_t min_frame,
+                                   std::int64_t max_frame,
+                                   std::vector<search_entry> &entries) {
+   entries.clear();
+
+   auto &stmt = find_text_in_region_;
+   stmt.reset();
+   stmt.bind(":ptext", text);
+   stmt.bind(":pleft", area.left);
+   stmt.bind(":ptop", area.top);
+   stmt.bind(":pright", area.right);
+   stmt.bind(":pbottom", area.bottom);
+   stmt.bind(":pmin", min_frame);
+   stmt.bind(":pmax", max_frame);
+
+   while (stmt.step()) {
+      read_search_entry(stmt, 0, entries.emplace_back());
+   }
+}
+
+void database::find_text_near(const std::string &text,
+                              const std::string &other_text,
+                              int max_distance,
+                              std::vector<search_entry> &entries) {
+   using limits = std::numeric_limits<std::int64_t>;
+   find_text_near(text, other_text, max_distance, limits::min(), limits::max(), entries);
+}
+
+void database::find_text_near(const std::string &text,
+                              const std::string &other_text,
+                              int max_distance,
+                              std::int64_t min_frame,
+                              std::int64_t max_frame,
+                              std::vector<search_entry> &entries) {
+   entries.clear();
+
+   auto &stmt = find_text_near_;
+   stmt.reset();
+   stmt.bind(":ptext", text);
+   stmt.bind(":pother", other_text);
+   stmt.bind(":pdistance", max_distance);
+   stmt.bind(":pmin", min_frame);
+   stmt.bind(":pmax", max_frame);
+
+   while (stmt.step()) {
+      read_search_entry(stmt, 0, entries.emplace_back());
+      read_search_entry(stmt, 5, entries.emplace_back());
+   }
+}
+
+void database::find_text_fuzzy(const fuzzy_pattern &pattern, std::vector<search_entry> &entries) {
+   using limits = std::numeric_limits<std::int64_t>;
+   find_text_fuzzy(pattern, limits::min(), limits::max(), entries);
+}
+
+void database::find_text_fuzzy(const fuzzy_pattern &pattern,
+                               std::int64_t min_frame,
+                               std::int64_t max_frame,
+                               std::vector<search_entry> &entries) {
+   entries.clear();
+
+   std::vector<text_value> matching;
+   {
+      auto &stmt = get_text_entries_;
+      stmt.reset();
+      stmt.bind(":pid", std::numeric_limits<std::int64_t>::min());
+
+      std::int64_t id;
+      std::string value;
+      while (stmt.step()) {
+         stmt.get(0, id);
+         stmt.get(1, value);
+         if (pattern.matches(value)) {
+            matching.push_back({id, value});
+         }
+      }
+   }
+
+   auto &stmt = get_text_spans_;
+   for (const auto &[text_id, value] : matching) {
+      stmt.reset();
+      stmt.bind(":pid", text_id);
+      stmt.bind(":pmin", min_frame);
+      stmt.bind(":pmax", max_frame);
+
+      while (stmt.step()) {
+         std::int64_t box;
+         int confidence;
+
+         auto &entry = entries.emplace_back();
+         stmt.get(0, entry.frame_number);
+         stmt.get(1, entry.last_frame_number);
+         stmt.get(2, box);
+         stmt.get(3, confidence);
+         entry.text = value;
+
+         const auto unpacked = unpack_box(box);
+         entry.left = unpacked.left;
+         entry.top = unpacked.top;
+         entry.right = unpacked.right;
+         entry.bottom = unpacked.bottom;
+         entry.confidence = dequantize_confidence(confidence);
+      }
+   }
+}
+
+void database::add_to_trigram_filter(const std::string &text) {
+   trigram_filter_words_t words;
+   ocs::common::add_to_trigram_filter(text, words);
+
+   auto &stmt = add_trigram_filter_bits_;
+   for (const auto &[word, bits] : words) {
+      stmt.reset();
+      stmt.bind(":pword", word);
+      stmt.bind(":pbits", static_cast<std::int64_t>(bits));
+      stmt.execute();
+   }
+}
+
+bool database::may_contain(const std::string &pattern) {
+   auto &stmt = get_trigram_filter_word_;
+
+   for (const auto trigram : like_pattern_trigrams(pattern)) {
+      for (const auto &bit : trigram_filter_bits(trigram)) {
+         stmt.reset();
+         stmt.bind(":pword", bit.word);
+
+         std::int64_t bits = 0;
+         if (stmt.step()) {
+            stmt.get(0, bits);
+         }
+
+         // Note: a statement left in progress keeps the read transaction open, blocking the writer
+         stmt.reset();
+
+         if ((static_cast<std::uint64_t>(bits) & bit.mask) == 0) {
+            return false;
+         }
+      }
+   }
+
+   return true;
+}
+
+void database::get_text_entries(std::int64_t after_id, std::vector<text_value> &entries) {
+   entries.clear();
+
+   auto &stmt = get_text_entries_;
+   stmt.reset();
+   stmt.bind(":pid", after_id);
 
    while (stmt.step()) {
       entries.emplace_back();
       auto &entry = entries.back();
-      stmt.get(0, entry.frame_number);
-      stmt.get(1, entry.left);
-      stmt.get(2, entry.top);
-      stmt.get(3, entry.right);
-      stmt.get(4, entry.bottom);
-      stmt.get(5, entry.confidence);
-      stmt.get(6, entry.text);
+      stmt.get(0, entry.id);
+      stmt.get(1, entry.value);
+   }
+}
+
+std::chrono::milliseconds database::video_info::frame_number_to_milliseconds(std::int64_t frame_number) const {
+   // Note: has to match ffmpeg::decoder::frame_number_to_milliseconds
+   const auto fractional_seconds = static_cast<double>(frame_number) / frame_rate;
+   const auto fractional_milliseconds = fractional_seconds * 1000.0;
+   return std::chrono::milliseconds{static_cast<std::int64_t>(fractional_milliseconds)};
+}
+
+void database::store_video_info(const video_info &info) {
+   std::lock_guard lock{database_mutex_};
+
+   // Note: unknown values are stored as -1 and turned into NULLs by the statement itself. The length is never
+   // shortened, as the decoder only knows a part of a recording which is still being written.
+   auto &stmt = store_video_info_;
+   stmt.reset();
+   stmt.bind(":pfps", info.frame_rate);
+   stmt.bind(":ptbnum", info.time_base_num);
+   stmt.bind(":ptbden", info.time_base_den);
+   stmt.bind(":pduration", static_cast<std::int64_t>(info.duration.value_or(std::chrono::milliseconds{-1}).count()));
+   stmt.bind(":pcount", info.frame_count.value_or(-1));
+   stmt.bind(":pstart", static_cast<std::int64_t>(info.start_time.value_or(std::chrono::milliseconds{-1}).count()));
+   stmt.execute();
+}
+
+auto database::get_video_info() -> std::optional<video_info> {
+   std::lock_guard lock{database_mutex_};
+
+   auto &stmt = get_video_info_;
+   stmt.reset();
+   if (!stmt.step() || stmt.is_null(0)) {
+      stmt.reset();
+      return std::nullopt;
+   }
+
+   auto get_optional = [&](int idx) -> std::optional<std::int64_t> {
+      if (stmt.is_null(idx)) {
+         return std::nullopt;
+      }
+
+      std::int64_t value;
+      stmt.get(idx, value);
+      return value;
+   };
+
+   video_info result{};
+   stmt.get(0, result.frame_rate);
+   stmt.get(1, result.time_base_num);
+   stmt.get(2, result.time_base_den);
+
+   if (const auto duration = get_optional(3)) {
+      result.duration = std::chrono::milliseconds{*duration};
+   }
+
+   result.frame_count = get_optional(4);
+
+   if (const auto start_time = get_optional(5)) {
+      result.start_time = std::chrono::milliseconds{*start_time};
+   }
+
+   stmt.reset();
+
+   if (result.frame_rate <= 0.0) {
+      return std::nullopt;
    }
+
+   return result;
+}
+
+void database::add_thumbnail(const thumbnail &thumb) {
+   auto &stmt = add_thumbnail_;
+   stmt.reset();
+   stmt.bind(":pnum", thumb.frame_number);
+   stmt.bind(":pwidth", thumb.width);
+   stmt.bind(":pheight", thumb.height);
+   stmt.bind(":pfwidth", thumb.frame_width);
+   stmt.bind(":pfheight", thumb.frame_height);
+   stmt.bind(":pimage", thumb.jpeg);
+   stmt.execute();
+}
+
+std::optional<thumbnail> database::get_thumbnail(std::int64_t frame_number) {
+   std::lock_guard lock{database_mutex_};
+
+   auto &stmt = get_thumbnail_;
+   stmt.reset();
+   stmt.bind(":pnum", frame_number);
+   if (!stmt.step()) {
+      stmt.reset();
+      return std::nullopt;
+   }
+
+   thumbnail result;
+   stmt.get(0, result.frame_number);
+   stmt.get(1, result.width);
+   stmt.get(2, result.height);
+   stmt.get(3, result.frame_width);
+   stmt.get(4, result.frame_height);
+   stmt.get(5, result.jpeg);
+   stmt.reset();
+
+   return result;
+}
+
+std::uint32_t database::read_change_counter(const std::string &db_path) {
+   // Note: a 4-byte big-endian integer at the offset 24 of the database header
+   const std::streamoff change_counter_offset = 24;
+
+   std::ifstream file{db_path, std::ios::binary};
+   std::array<unsigned char, 4> bytes{};
+   if (!file.seekg(change_counter_offset) || !file.read(reinterpret_cast<char *>(bytes.data()), bytes.size())) {
+      return 0;
+   }
+
+   return (std::uint32_t{bytes[0]} << 24) | (std::uint32_t{bytes[1]} << 16) | (std::uint32_t{bytes[2]} << 8) |
+          std::uint32_t{bytes[3]};
+}
+
+void database::vacuum() {
+   std::lock_guard lock{database_mutex_};
+   sqlite_burrito::statement::execute(db_.get_connection(), "VACUUM;");
+}
+
+void database::interrupt() {
+   // Note: no locking, the query being interrupted is holding the lock
+   sqlite3_interrupt(db_.get_connection().get_handle());
 }
 
 void database::prepare_statements() {
@@ -174,24 +779,116 @@ void database::prepare_statements() {
    get_starting_frame_number_.prepare(R"sql(SELECT last_processed_frame FROM metadata;)sql");
 
    if (!read_only_) {
-      add_text_instance_.prepare(
-R"sql(INSERT INTO text_instances("text_entry_id", "frame_num", "left", "top", "right", "bottom", "confidence")
-      VALUES (:ptid, :pnum, :pleft, :ptop, :pright, :pbottom, :pconfidence);)sql");
+      add_text_span_.prepare(
+R"sql(INSERT INTO text_spans("first_frame", "text_entry_id", "box", "last_frame", "confidence")
+      VALUES (:pfirst, :ptid, :pbox, :plast, :pconfidence)
+      ON CONFLICT(first_frame, text_entry_id, box) DO UPDATE SET
+         last_frame = MAX(last_frame, excluded.last_frame),
+         confidence = MAX(confidence, excluded.confidence);)sql");
+
+      update_text_span_.prepare(
+R"sql(UPDATE text_spans SET first_frame=:pfirst, last_frame=:plast, confidence=:pconfidence
+      WHERE first_frame = :pold_first AND text_entry_id = :ptid AND box = :pbox;)sql");
+
+      remove_text_span_.prepare(
+R"sql(DELETE FROM text_spans
+      WHERE first_frame = :pfirst AND text_entry_id = :ptid AND box = :pbox
+      RETURNING last_frame, confidence;)sql");
+
+      get_open_spans_.prepare(
+R"sql(SELECT text_entry_id, first_frame, last_frame, box, confidence
+      FROM text_spans
+      WHERE last_frame >= :pmin;)sql");
 
       add_text_entry_.prepare(R"sql(INSERT OR IGNORE INTO text_entries("value") VALUES (:pvalue);)sql");
 
-      store_last_frame_number_.prepare(R"sql(UPDATE metadata SET last_processed_frame=:pnum;)sql");
+      add_trigram_filter_bits_.prepare(
+R"sql(INSERT INTO trigram_filter(word, "bits") VALUES (:pword, :pbits)
+      ON CONFLICT(word) DO UPDATE SET "bits" = "bits" | excluded."bits";)sql");
+
+      // Note: the length of a recording, which is still being written, is only known up to the processed frames
+      store_last_frame_number_.prepare(
+R"sql(UPDATE metadata SET
+         last_processed_frame=:pnum,
+         frame_count=MAX(COALESCE(frame_count, 0), :pnum + 1),
+         duration_ms=CASE WHEN fps > 0
+                          THEN MAX(COALESCE(duration_ms, 0), CAST((:pnum + 1) * 1000.0 / fps AS INT))
+                          ELSE duration_ms
+                     END;)sql");
+
+      store_video_info_.prepare(
+R"sql(UPDATE metadata SET
+         fps=:pfps,
+         time_base_num=:ptbnum,
+         time_base_den=:ptbden,
+         duration_ms=NULLIF(MAX(COALESCE(duration_ms, -1), :pduration), -1),
+         frame_count=NULLIF(MAX(COALESCE(frame_count, -1), :pcount), -1),
+         start_time_ms=NULLIF(:pstart, -1);)sql");
+
+      store_span_options_.prepare(R"sql(UPDATE metadata SET max_frame_gap=:pgap, open_span_frames=:pwindow;)sql");
+
+      add_thumbnail_.prepare(
+R"sql(INSERT OR REPLACE INTO thumbnails(frame_number, width, height, frame_width, frame_height, image)
+      VALUES (:pnum, :pwidth, :pheight, :pfwidth, :pfheight, :pimage);)sql");
    }
 
    get_text_entry_id_.prepare(R"sql(SELECT id FROM text_entries WHERE value == :ptext;)sql");
 
-   is_frame_number_present_.prepare(R"sql(SELECT COUNT(*) FROM text_instances WHERE frame_num = :pnum;)sql");
-
    find_text_.prepare(
-R"sql(SELECT frame_num, "left", top, "right", bottom, confidence, value
-      FROM text_instances
-      LEFT JOIN  text_entries te ON text_instances.text_entry_id = te.id
-      WHERE te.value LIKE :ptext;)sql");
+R"sql(SELECT first_frame, last_frame, box, confidence, value
+      FROM text_spans
+      LEFT JOIN  text_entries te ON text_spans.text_entry_id = te.id
+      WHERE first_frame BETWEEN :pmin AND :pmax AND last_frame >= :plast AND te.value LIKE :ptext;)sql");
+
+   // Note: the spatial constraints are resolved by the R*Tree, the span itself is looked up by its primary key
+   find_text_crossing_.prepare(
+R"sql(SELECT b.min_frame, b.max_frame, b.box, s.confidence, te.value
+      FROM text_boxes b
+      JOIN text_entries te ON te.id = b.text_entry_id
+      JOIN text_spans s ON s.first_frame = b.min_frame AND s.text_entry_id = b.text_entry_id AND s.box = b.box
+      WHERE b.min_frame < :pframe AND b.max_frame >= :pframe AND te.value LIKE :ptext;)sql");
+
+   find_text_in_region_.prepare(
+R"sql(SELECT b.min_frame, b.max_frame, b.box, s.confidence, te.value
+      FROM text_boxes b
+      JOIN text_entries te ON te.id = b.text_entry_id
+      JOIN text_spans s ON s.first_frame = b.min_frame AND s.text_entry_id = b.text_entry_id AND s.box = b.box
+      WHERE b.min_x <= :pright AND b.max_x >= :pleft AND b.min_y <= :pbottom AND b.max_y >= :ptop
+        AND b.min_frame <= :pmax AND b.max_frame >= :pmin
+        AND te.value LIKE :ptext;)sql");
+
+   // Note: driven by the spans of the matching texts, the neighbours of each span are probed in the R*Tree around the
+   // box of the span. CROSS JOIN keeps SQLite from reordering the tables.
+   find_text_near_.prepare(
+R"sql(SELECT MAX(sa.first_frame, b.min_frame), MIN(sa.last_frame, b.max_frame), sa.box, sa.confidence, ta.value,
+             MAX(sa.first_frame, b.min_frame), MIN(sa.last_frame, b.max_frame), b.box, sb.confidence, tb.value
+      FROM text_entries ta
+      CROSS JOIN text_spans sa ON sa.text_entry_id = ta.id AND sa.first_frame <= :pmax AND sa.last_frame >= :pmin
+      CROSS JOIN text_boxes a ON a.min_frame = sa.first_frame AND a.max_frame = sa.last_frame
+                             AND a.text_entry_id = sa.text_entry_id AND a.box = sa.box
+      CROSS JOIN text_boxes b ON b.min_frame <= a.max_frame AND b.max_frame >= a.min_frame
+                             AND b.min_x <= a.max_x + :pdistance AND b.max_x >= a.min_x - :pdistance
+                             AND b.min_y <= a.max_y + :pdistance AND b.max_y >= a.min_y - :pdistance
+      JOIN text_entries tb ON tb.id = b.text_entry_id
+      JOIN text_spans sb ON sb.first_frame = b.min_frame AND sb.text_entry_id = b.text_entry_id AND sb.box = b.box
+      WHERE ta.value LIKE :ptext AND a.id != b.id AND tb.value LIKE :pother;)sql");
+
+   get_text_spans_.prepare(
+R"sql(SELECT first_frame, last_frame, box, confidence
+      FROM text_spans
+      WHERE text_entry_id = :pid AND first_frame <= :pmax AND last_frame >= :pmin;)sql");
+
+   get_text_entries_.prepare(R"sql(SELECT id, value FROM text_entries WHERE id > :pid ORDER BY id;)sql");
+
+   get_trigram_filter_word_.prepare(R"sql(SELECT "bits" FROM trigram_filter WHERE word = :pword;)sql");
+
+   get_video_info_.prepare(
+R"sql(SELECT fps, time_base_num, time_base_den, duration_ms, frame_count, start_time_ms FROM metadata;)sql");
+
+   get_span_options_.prepare(R"sql(SELECT max_frame_gap, open_span_frames FROM metadata;)sql");
+
+   get_thumbnail_.prepare(
+R"sql(SELECT frame_number, width, height, frame_width, frame_height, image FROM thumbnails WHERE frame_number = :pnum;)sql");
 
    // clang-format on
 }
@@ -0,0 +1,147 @@
+//
+// Created by Dennis Sitelew on 18.10.26.
+//
+
+#ifndef OCS_IDL_INCLUDE
+#error Internal use only
+#endif
+
+#include <functional>
+#include <string>
+#include <utility>
+
+namespace {
+
+//! Key range for a chunked step, both ends are inclusive
+using key_range_t = std::pair<std::int64_t, std::int64_t>;
+
+//! Copy all the rows with keys in the (from, to] range
+using copy_chunk_cb_t = std::function<void(std::int64_t from, std::int64_t to)>;
+
+bool table_exists(sqlite_burrito::versioned_database &db, const std::string &name) {
+   sqlite_burrito::statement stmt{db.get_connection()};
+   stmt.prepare(R"sql(SELECT EXISTS(SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = :pname);)sql");
+   stmt.reset();
+   stmt.bind(":pname", name);
+   stmt.step();
+
+   bool result;
+   stmt.get(0, result);
+   return result;
+}
+
+bool column_exists(sqlite_burrito::versioned_database &db, const std::string &table, const std::string &column) {
+   sqlite_burrito::statement stmt{db.get_connection()};
+   stmt.prepare(R"sql(SELECT EXISTS(SELECT 1 FROM pragma_table_info(:ptable) WHERE name = :pcolumn);)sql");
+   stmt.reset();
+   stmt.bind(":ptable", table);
+   stmt.bind(":pcolumn", column);
+   stmt.step();
+
+   bool result;
+   stmt.get(0, result);
+   return result;
+}
+
+//! @return MIN and MAX values returned by the query, or an empty range (1, 0) if the table has no rows
+key_range_t get_key_range(sqlite_burrito::versioned_database &db, const std::string &sql) {
+   sqlite_burrito::statement stmt{db.get_connection()};
+   stmt.prepare(sql);
+   stmt.reset();
+
+   key_range_t result{1, 0};
+   if (stmt.step() && !stmt.is_null(0) && !stmt.is_null(1)) {
+      stmt.get(0, result.first);
+      stmt.get(1, result.second);
+   }
+   return result;
+}
+
+//! Create the checkpoints table, should be called before preparing any statements used by the chunked steps
+void create_progress_table(sqlite_burrito::versioned_database &db) {
+   sqlite_burrito::statement::execute(db.get_connection(), R"sql(
+CREATE TABLE IF NOT EXISTS migration_progress (
+   step TEXT PRIMARY KEY NOT NULL,
+   last_key INT NOT NULL
+);
+)sql");
+}
+
+/**
+ * Run a set-based migration step in chunks of `chunk_size` keys, each chunk in its own transaction.
+ *
+ * The last migrated key is checkpointed in the `migration_progress` table together with the chunk itself, so an
+ * interrupted migration continues from the last committed chunk when the database is opened again.
+ */
+void run_chunked_step(sqlite_burrito::versioned_database &db,
+                      const std::string &step,
+                      const key_range_t &keys,
+                      std::int64_t chunk_size,
+                      const copy_chunk_cb_t &copy_chunk) {
+   auto &con = db.get_connection();
+
+   sqlite_burrito::statement get_checkpoint{con};
+   get_checkpoint.prepare(R"sql(SELECT last_key FROM migration_progress WHERE step = :pstep;)sql");
+
+   sqlite_burrito::statement set_checkpoint{con};
+   set_checkpoint.prepare(R"sql(INSERT OR REPLACE INTO migration_progress(step, last_key) VALUES (:pstep, :pkey);)sql");
+
+   const auto [min_key, max_key] = keys;
+
+   std::int64_t last_key = min_key - 1;
+   get_checkpoint.reset();
+   get_checkpoint.bind(":pstep", step);
+   if (get_checkpoint.step()) {
+      get_checkpoint.get(0, last_key);
+      spdlog::info("{}: resuming after key {}", step, last_key);
+   }
+
+   const auto total = static_cast<double>(std::max<std::int64_t>(max_key - min_key + 1, 1));
+
+   while (last_key < max_key) {
+      const auto chunk_end = std::min(last_key + chunk_size, max_key);
+
+      auto transaction = con.begin_transaction();
+
+      copy_chunk(last_key, chunk_end);
+
+      set_checkpoint.reset();
+      set_checkpoint.bind(":pstep", step);
+      set_checkpoint.bind(":pkey", chunk_end);
+      set_checkpoint.execute();
+
+      transaction.commit();
+
+      last_key = chunk_end;
+      spdlog::info("{}: {:.1f}%", step, (static_cast<double>(last_key - min_key + 1) / total) * 100.0);
+   }
+}
+
+//! Remove the step checkpoint, should be called once the old data is dropped. The checkpoints table itself is dropped
+//! together with the last checkpoint, it's only needed while a migration is in progress.
+void finish_chunked_step(sqlite_burrito::versioned_database &db, const std::string &step) {
+   if (!table_exists(db, "migration_progress")) {
+      return;
+   }
+
+   sqlite_burrito::statement stmt{db.get_connection()};
+   stmt.prepare(R"sql(DELETE FROM migration_progress WHERE step = :pstep;)sql");
+   stmt.reset();
+   stmt.bind(":pstep", step);
+   stmt.execute();
+
+   sqlite_burrito::statement any_left{db.get_connection()};
+   any_left.prepare(R"sql(SELECT EXISTS(SELECT 1 FROM migration_progress);)sql");
+   any_left.reset();
+   any_left.step();
+
+   bool result;
+   any_left.get(0, result);
+   any_left.reset();
+
+   if (!result) {
+      sqlite_burrito::statement::execute(db.get_connection(), "DROP TABLE migration_progress;");
+   }
+}
+
+} // namespace
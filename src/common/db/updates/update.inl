@@ -6,7 +6,7 @@
 #error Internal use only
 #endif
 
-const int database::CURRENT_DB_VERSION = 4;
+const int database::CURRENT_DB_VERSION = 12;
 
 inline void database::db_update(sqlite_burrito::versioned_database &con, int from, std::error_code &ec) {
    spdlog::trace("Updating database: from version {}", from);
@@ -28,6 +28,38 @@ inline void database::db_update(sqlite_burrito::versioned_database &con, int fro
          update_v3(con, ec);
          return;
 
+      case 4:
+         update_v4(con, ec);
+         return;
+
+      case 5:
+         update_v5(con, ec);
+         return;
+
+      case 6:
+         update_v6(con, ec);
+         return;
+
+      case 7:
+         update_v7(con, ec);
+         return;
+
+      case 8:
+         update_v8(con, ec);
+         return;
+
+      case 9:
+         update_v9(con, ec);
+         return;
+
+      case 10:
+         update_v10(con, ec);
+         return;
+
+      case 11:
+         update_v11(con, ec);
+         return;
+
       default:
          ec = std::make_error_code(std::errc::invalid_argument);
    }
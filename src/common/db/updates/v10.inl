@@ -0,0 +1,20 @@
+//
+// Created by Dennis Sitelew on 18.10.26.
+//
+
+#ifndef OCS_IDL_INCLUDE
+#error Internal use only
+#endif
+
+namespace {
+
+void update_v10(sqlite_burrito::versioned_database &db, std::error_code &ec) {
+   // The spans of a text, for the searches starting from the matching text entries. The primary key columns are
+   // appended to the index, so the spans of a text are ordered by their first frame.
+   const auto sql = R"sql(
+CREATE INDEX IF NOT EXISTS text_spans_text_entry_idx ON text_spans(text_entry_id);
+)sql";
+   sqlite_burrito::statement::execute(db.get_connection(), sql, ec);
+}
+
+} // namespace
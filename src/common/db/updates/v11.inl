@@ -0,0 +1,24 @@
+//
+// Created by Dennis Sitelew on 19.10.26.
+//
+
+#ifndef OCS_IDL_INCLUDE
+#error Internal use only
+#endif
+
+namespace {
+
+void update_v11(sqlite_burrito::versioned_database &db, std::error_code &ec) {
+   // Note: unknown for the existing databases, those are filled by ocr-suite on the next run
+   const auto sql = R"sql(
+BEGIN TRANSACTION;
+
+ALTER TABLE metadata ADD COLUMN max_frame_gap INT;
+ALTER TABLE metadata ADD COLUMN open_span_frames INT;
+
+COMMIT;
+)sql";
+   sqlite_burrito::statement::execute(db.get_connection(), sql, ec);
+}
+
+} // namespace
@@ -0,0 +1,174 @@
+//
+// Created by Dennis Sitelew on 18.10.26.
+//
+
+#ifndef OCS_IDL_INCLUDE
+#error Internal use only
+#endif
+
+namespace {
+
+void update_v4_safe(sqlite_burrito::versioned_database &db) {
+   // Note: the schema update has to be idempotent, we might be resuming an interrupted migration
+   const auto schema_update = R"sql(
+CREATE TABLE IF NOT EXISTS text_spans (
+   id INTEGER PRIMARY KEY AUTOINCREMENT NOT NULL,
+   text_entry_id INTEGER NOT NULL,
+   "first_frame" INT NOT NULL,
+   "last_frame" INT NOT NULL,
+   "left" INT,
+   "top" INT,
+   "right" INT,
+   "bottom" INT,
+   "confidence" FLOAT,
+
+   FOREIGN KEY(text_entry_id)
+      REFERENCES text_entries(id)
+      ON UPDATE CASCADE
+      ON DELETE CASCADE
+);
+)sql";
+   sqlite_burrito::statement::execute(db.get_connection(), schema_update);
+   create_progress_table(db);
+
+   if (table_exists(db, "text_instances")) {
+      // Allows collapsing the instances of a range of text entries without scanning the whole table
+      spdlog::info("Indexing text instances");
+      sqlite_burrito::statement::execute(db.get_connection(), R"sql(
+CREATE INDEX IF NOT EXISTS text_instances_migration_frame_idx ON text_instances(text_entry_id, frame_num);
+)sql");
+
+      sqlite_burrito::statement get_instances_stmt{db.get_connection()};
+      get_instances_stmt.prepare(R"sql(
+SELECT text_entry_id, frame_num, "left", top, "right", bottom, IFNULL(confidence, 0)
+FROM text_instances
+WHERE text_entry_id > :pfrom AND text_entry_id <= :pto
+ORDER BY text_entry_id, frame_num;
+)sql");
+
+      sqlite_burrito::statement ins_span_stmt{db.get_connection()};
+      ins_span_stmt.prepare(R"sql(
+INSERT INTO text_spans("text_entry_id", "first_frame", "last_frame", "left", "top", "right", "bottom", "confidence")
+VALUES (:ptid, :pfirst, :plast, :pleft, :ptop, :pright, :pbottom, :pconfidence);
+)sql");
+
+      struct migrated_span {
+         std::int64_t first_frame;
+         std::int64_t last_frame;
+         int left, top, right, bottom;
+         double confidence;
+      };
+
+      // Note: the same rules as for the spans built by the writer, with the default options
+      const database::span_options opts{};
+
+      auto add_span = [&](std::int64_t text_id, const migrated_span &span) {
+         ins_span_stmt.reset();
+         ins_span_stmt.bind(":ptid", text_id);
+         ins_span_stmt.bind(":pfirst", span.first_frame);
+         ins_span_stmt.bind(":plast", span.last_frame);
+         ins_span_stmt.bind(":pleft", span.left);
+         ins_span_stmt.bind(":ptop", span.top);
+         ins_span_stmt.bind(":pright", span.right);
+         ins_span_stmt.bind(":pbottom", span.bottom);
+         ins_span_stmt.bind(":pconfidence", span.confidence);
+         ins_span_stmt.execute();
+      };
+
+      // Collapse the per-frame instances of each text into spans: an instance extends an open span if its box
+      // differs by at most `max_box_delta` pixels, and it's at most `max_frame_gap` frames after the span
+      auto copy_chunk = [&](std::int64_t from, std::int64_t to) {
+         get_instances_stmt.reset();
+         get_instances_stmt.bind(":pfrom", from);
+         get_instances_stmt.bind(":pto", to);
+
+         std::int64_t text_id = -1;
+         std::vector<migrated_span> open_spans;
+
+         auto close_spans = [&](std::int64_t before_frame) {
+            auto is_closed = [&](const migrated_span &span) { return span.last_frame < before_frame; };
+            for (const auto &span : open_spans) {
+               if (is_closed(span)) {
+                  add_span(text_id, span);
+               }
+            }
+            open_spans.erase(std::remove_if(std::begin(open_spans), std::end(open_spans), is_closed),
+                             std::end(open_spans));
+         };
+
+         while (get_instances_stmt.step()) {
+            std::int64_t instance_text_id, frame_num;
+            migrated_span instance{};
+            get_instances_stmt.get(0, instance_text_id);
+            get_instances_stmt.get(1, frame_num);
+            get_instances_stmt.get(2, instance.left);
+            get_instances_stmt.get(3, instance.top);
+            get_instances_stmt.get(4, instance.right);
+            get_instances_stmt.get(5, instance.bottom);
+            get_instances_stmt.get(6, instance.confidence);
+            instance.first_frame = frame_num;
+            instance.last_frame = frame_num;
+
+            if (instance_text_id != text_id) {
+               close_spans(std::numeric_limits<std::int64_t>::max());
+               text_id = instance_text_id;
+            } else {
+               close_spans(frame_num - opts.max_frame_gap);
+            }
+
+            auto is_same_box = [&](const migrated_span &span) {
+               return std::abs(span.left - instance.left) <= opts.max_box_delta &&
+                      std::abs(span.top - instance.top) <= opts.max_box_delta &&
+                      std::abs(span.right - instance.right) <= opts.max_box_delta &&
+                      std::abs(span.bottom - instance.bottom) <= opts.max_box_delta;
+            };
+
+            auto it = std::find_if(std::begin(open_spans), std::end(open_spans), is_same_box);
+            if (it == std::end(open_spans)) {
+               open_spans.push_back(instance);
+               continue;
+            }
+
+            it->last_frame = frame_num;
+            it->confidence = std::max(it->confidence, instance.confidence);
+         }
+
+         close_spans(std::numeric_limits<std::int64_t>::max());
+      };
+
+      // Islands never cross text entries, so chunking by the text entry ID is exact
+      spdlog::info("Collapsing text instances into spans");
+      const auto keys = get_key_range(db, R"sql(SELECT MIN(id), MAX(id) FROM text_entries;)sql");
+      run_chunked_step(db, "v4", keys, 20'000, copy_chunk);
+
+      spdlog::info("Dropping old table");
+      sqlite_burrito::statement::execute(db.get_connection(), "DROP TABLE text_instances;");
+   }
+
+   sqlite_burrito::statement::execute(db.get_connection(), R"sql(
+CREATE INDEX IF NOT EXISTS text_spans_first_frame_idx ON text_spans(first_frame);
+CREATE INDEX IF NOT EXISTS text_spans_last_frame_idx ON text_spans(last_frame);
+)sql");
+
+   finish_chunked_step(db, "v4");
+}
+
+void update_v4(sqlite_burrito::versioned_database &db, std::error_code &ec) {
+   // Migrate from one row per word per frame to text appearance spans
+
+   try {
+      spdlog::info("Updating DB schema");
+
+      update_v4_safe(db);
+
+      spdlog::info("Migration done!");
+   } catch (const std::system_error &e) {
+      spdlog::error("Database upgrade failed: {}", e.what());
+      ec = e.code();
+   } catch (...) {
+      spdlog::error("Database upgrade failed");
+      ec = std::make_error_code(std::errc::bad_message);
+   }
+}
+
+} // namespace
@@ -0,0 +1,28 @@
+//
+// Created by Dennis Sitelew on 18.10.26.
+//
+
+#ifndef OCS_IDL_INCLUDE
+#error Internal use only
+#endif
+
+namespace {
+
+void update_v5(sqlite_burrito::versioned_database &db, std::error_code &ec) {
+   // Note: all values are unknown for the existing databases, they are filled by ocr-suite on the next run
+   const auto sql = R"sql(
+BEGIN TRANSACTION;
+
+ALTER TABLE metadata ADD COLUMN fps REAL;
+ALTER TABLE metadata ADD COLUMN time_base_num INT;
+ALTER TABLE metadata ADD COLUMN time_base_den INT;
+ALTER TABLE metadata ADD COLUMN duration_ms INT;
+ALTER TABLE metadata ADD COLUMN frame_count INT;
+ALTER TABLE metadata ADD COLUMN start_time_ms INT;
+
+COMMIT;
+)sql";
+   sqlite_burrito::statement::execute(db.get_connection(), sql, ec);
+}
+
+} // namespace
@@ -0,0 +1,106 @@
+//
+// Created by Dennis Sitelew on 18.10.26.
+//
+
+#ifndef OCS_IDL_INCLUDE
+#error Internal use only
+#endif
+
+namespace {
+
+void update_v6_safe(sqlite_burrito::versioned_database &db) {
+   // Note: the schema update has to be idempotent, we might be resuming an interrupted migration
+   if (column_exists(db, "text_spans", "id")) {
+      sqlite_burrito::statement::execute(db.get_connection(), R"sql(
+BEGIN TRANSACTION;
+
+DROP INDEX IF EXISTS text_spans_first_frame_idx;
+DROP INDEX IF EXISTS text_spans_last_frame_idx;
+ALTER TABLE text_spans RENAME TO text_spans_v5;
+
+COMMIT;
+)sql");
+   }
+
+   // Spans are clustered by the first frame, the box coordinates are packed into a single integer (see packed_box.h)
+   // and confidence is stored as an integer percentage.
+   const auto schema_update = R"sql(
+CREATE TABLE IF NOT EXISTS text_spans (
+   "first_frame" INT NOT NULL,
+   text_entry_id INTEGER NOT NULL,
+   "box" INT NOT NULL,
+   "last_frame" INT NOT NULL,
+   "confidence" INT NOT NULL,
+
+   PRIMARY KEY(first_frame, text_entry_id, box),
+
+   FOREIGN KEY(text_entry_id)
+      REFERENCES text_entries(id)
+      ON UPDATE CASCADE
+      ON DELETE CASCADE
+) WITHOUT ROWID;
+)sql";
+   sqlite_burrito::statement::execute(db.get_connection(), schema_update);
+   create_progress_table(db);
+
+   if (table_exists(db, "text_spans_v5")) {
+      // Note: spans with the same text and box are never starting at the same frame, but in case they do, they are
+      // merged into one. The boxes are packed like ocs::common::pack_box does, the SQLite shifts are working on the
+      // two's complement representation, so a left coordinate above 32767 gives the same negative value.
+      sqlite_burrito::statement copy_stmt{db.get_connection()};
+      copy_stmt.prepare(R"sql(
+INSERT INTO text_spans("first_frame", "text_entry_id", "box", "last_frame", "confidence")
+SELECT first_frame, text_entry_id,
+       (MIN(MAX(IFNULL("left", 0), 0), 65535) << 48) | (MIN(MAX(IFNULL(top, 0), 0), 65535) << 32) |
+       (MIN(MAX(IFNULL("right", 0), 0), 65535) << 16) | MIN(MAX(IFNULL(bottom, 0), 0), 65535),
+       last_frame,
+       MIN(MAX(CAST(ROUND(IFNULL(confidence, 0)) AS INT), 0), 100)
+FROM text_spans_v5
+WHERE id > :pfrom AND id <= :pto
+ON CONFLICT(first_frame, text_entry_id, box) DO UPDATE SET
+   last_frame = MAX(last_frame, excluded.last_frame),
+   confidence = MAX(confidence, excluded.confidence);
+)sql");
+
+      auto copy_chunk = [&](std::int64_t from, std::int64_t to) {
+         copy_stmt.reset();
+         copy_stmt.bind(":pfrom", from);
+         copy_stmt.bind(":pto", to);
+         copy_stmt.execute();
+      };
+
+      spdlog::info("Copying spans to the compact table");
+      const auto keys = get_key_range(db, R"sql(SELECT MIN(id), MAX(id) FROM text_spans_v5;)sql");
+      run_chunked_step(db, "v6", keys, 500'000, copy_chunk);
+
+      spdlog::info("Dropping old table");
+      sqlite_burrito::statement::execute(db.get_connection(), "DROP TABLE text_spans_v5;");
+   }
+
+   // The first frame is covered by the primary key
+   sqlite_burrito::statement::execute(db.get_connection(), R"sql(
+CREATE INDEX IF NOT EXISTS text_spans_last_frame_idx ON text_spans(last_frame);
+)sql");
+
+   finish_chunked_step(db, "v6");
+}
+
+void update_v6(sqlite_burrito::versioned_database &db, std::error_code &ec) {
+   // Migrate the spans to a compact WITHOUT ROWID table
+
+   try {
+      spdlog::info("Updating DB schema");
+
+      update_v6_safe(db);
+
+      spdlog::info("Migration done!");
+   } catch (const std::system_error &e) {
+      spdlog::error("Database upgrade failed: {}", e.what());
+      ec = e.code();
+   } catch (...) {
+      spdlog::error("Database upgrade failed");
+      ec = std::make_error_code(std::errc::bad_message);
+   }
+}
+
+} // namespace
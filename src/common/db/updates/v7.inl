@@ -0,0 +1,77 @@
+//
+// Created by Dennis Sitelew on 18.10.26.
+//
+
+#ifndef OCS_IDL_INCLUDE
+#error Internal use only
+#endif
+
+namespace {
+
+void update_v7_safe(sqlite_burrito::versioned_database &db) {
+   // Note: the schema update has to be idempotent, we might be resuming an interrupted migration
+   sqlite_burrito::statement::execute(db.get_connection(), R"sql(
+CREATE TABLE IF NOT EXISTS trigram_filter (
+   word INTEGER PRIMARY KEY NOT NULL,
+   "bits" INT NOT NULL
+);
+)sql");
+   create_progress_table(db);
+
+   sqlite_burrito::statement select_stmt{db.get_connection()};
+   select_stmt.prepare(R"sql(SELECT value FROM text_entries WHERE id > :pfrom AND id <= :pto;)sql");
+
+   // Note: the bits are OR-ed into the stored ones, so a chunk may be added again when resuming
+   sqlite_burrito::statement insert_stmt{db.get_connection()};
+   insert_stmt.prepare(R"sql(INSERT INTO trigram_filter(word, "bits") VALUES (:pword, :pbits)
+ON CONFLICT(word) DO UPDATE SET "bits" = "bits" | excluded."bits";)sql");
+
+   // The filter itself is small (at most 2^14 words), the words changed by a chunk are collected in memory
+   ocs::common::trigram_filter_words_t words;
+
+   auto add_chunk = [&](std::int64_t from, std::int64_t to) {
+      words.clear();
+
+      select_stmt.reset();
+      select_stmt.bind(":pfrom", from);
+      select_stmt.bind(":pto", to);
+      while (select_stmt.step()) {
+         std::string value;
+         select_stmt.get(0, value);
+         ocs::common::add_to_trigram_filter(value, words);
+      }
+      select_stmt.reset();
+
+      for (const auto &[word, bits] : words) {
+         insert_stmt.reset();
+         insert_stmt.bind(":pword", word);
+         insert_stmt.bind(":pbits", static_cast<std::int64_t>(bits));
+         insert_stmt.execute();
+      }
+   };
+
+   const auto keys = get_key_range(db, R"sql(SELECT MIN(id), MAX(id) FROM text_entries;)sql");
+   run_chunked_step(db, "v7", keys, 100'000, add_chunk);
+
+   finish_chunked_step(db, "v7");
+}
+
+void update_v7(sqlite_burrito::versioned_database &db, std::error_code &ec) {
+   // Build the trigram filter of the existing text entries
+
+   try {
+      spdlog::info("Building the trigram filter");
+
+      update_v7_safe(db);
+
+      spdlog::info("Migration done!");
+   } catch (const std::system_error &e) {
+      spdlog::error("Database upgrade failed: {}", e.what());
+      ec = e.code();
+   } catch (...) {
+      spdlog::error("Database upgrade failed");
+      ec = std::make_error_code(std::errc::bad_message);
+   }
+}
+
+} // namespace
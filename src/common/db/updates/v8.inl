@@ -0,0 +1,92 @@
+//
+// Created by Dennis Sitelew on 18.10.26.
+//
+
+#ifndef OCS_IDL_INCLUDE
+#error Internal use only
+#endif
+
+namespace {
+
+void update_v8_safe(sqlite_burrito::versioned_database &db) {
+   // Note: the schema update has to be idempotent, we might be resuming an interrupted migration
+   //
+   // The boxes of the spans in an R*Tree over (frames, x, y), kept in sync with the spans by the triggers. The text
+   // entry and the packed box are auxiliary columns, together with the first frame those are the span primary key.
+   const auto schema_update = R"sql(
+CREATE VIRTUAL TABLE IF NOT EXISTS text_boxes USING rtree_i32(
+   id,
+   min_frame, max_frame,
+   min_x, max_x,
+   min_y, max_y,
+   +text_entry_id INT,
+   +box INT
+);
+
+CREATE TRIGGER IF NOT EXISTS text_boxes_insert AFTER INSERT ON text_spans BEGIN
+   INSERT INTO text_boxes(min_frame, max_frame, min_x, max_x, min_y, max_y, text_entry_id, box)
+   VALUES (NEW.first_frame, NEW.last_frame,
+           MIN((NEW.box >> 48) & 65535, (NEW.box >> 16) & 65535), MAX((NEW.box >> 48) & 65535, (NEW.box >> 16) & 65535),
+           MIN((NEW.box >> 32) & 65535, NEW.box & 65535), MAX((NEW.box >> 32) & 65535, NEW.box & 65535),
+           NEW.text_entry_id, NEW.box);
+END;
+
+CREATE TRIGGER IF NOT EXISTS text_boxes_update AFTER UPDATE OF first_frame, last_frame ON text_spans BEGIN
+   UPDATE text_boxes SET min_frame = NEW.first_frame, max_frame = NEW.last_frame
+   WHERE min_frame = OLD.first_frame AND max_frame = OLD.last_frame
+     AND text_entry_id = OLD.text_entry_id AND box = OLD.box;
+END;
+
+CREATE TRIGGER IF NOT EXISTS text_boxes_delete AFTER DELETE ON text_spans BEGIN
+   DELETE FROM text_boxes
+   WHERE min_frame = OLD.first_frame AND max_frame = OLD.last_frame
+     AND text_entry_id = OLD.text_entry_id AND box = OLD.box;
+END;
+)sql";
+   sqlite_burrito::statement::execute(db.get_connection(), schema_update);
+   create_progress_table(db);
+
+   sqlite_burrito::statement copy_stmt{db.get_connection()};
+   copy_stmt.prepare(R"sql(
+INSERT INTO text_boxes(min_frame, max_frame, min_x, max_x, min_y, max_y, text_entry_id, box)
+SELECT first_frame, last_frame,
+       MIN((box >> 48) & 65535, (box >> 16) & 65535), MAX((box >> 48) & 65535, (box >> 16) & 65535),
+       MIN((box >> 32) & 65535, box & 65535), MAX((box >> 32) & 65535, box & 65535),
+       text_entry_id, box
+FROM text_spans
+WHERE first_frame > :pfrom AND first_frame <= :pto;
+)sql");
+
+   auto copy_chunk = [&](std::int64_t from, std::int64_t to) {
+      copy_stmt.reset();
+      copy_stmt.bind(":pfrom", from);
+      copy_stmt.bind(":pto", to);
+      copy_stmt.execute();
+   };
+
+   spdlog::info("Indexing text boxes");
+   const auto keys = get_key_range(db, R"sql(SELECT MIN(first_frame), MAX(first_frame) FROM text_spans;)sql");
+   run_chunked_step(db, "v8", keys, 100'000, copy_chunk);
+
+   finish_chunked_step(db, "v8");
+}
+
+void update_v8(sqlite_burrito::versioned_database &db, std::error_code &ec) {
+   // Spatial index of the text boxes
+
+   try {
+      spdlog::info("Updating DB schema");
+
+      update_v8_safe(db);
+
+      spdlog::info("Migration done!");
+   } catch (const std::system_error &e) {
+      spdlog::error("Database upgrade failed: {}", e.what());
+      ec = e.code();
+   } catch (...) {
+      spdlog::error("Database upgrade failed");
+      ec = std::make_error_code(std::errc::bad_message);
+   }
+}
+
+} // namespace
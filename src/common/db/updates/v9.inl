@@ -0,0 +1,38 @@
+//
+// Created by Dennis Sitelew on 18.10.26.
+//
+
+#ifndef OCS_IDL_INCLUDE
+#error Internal use only
+#endif
+
+namespace {
+
+void update_v9(sqlite_burrito::versioned_database &db, std::error_code &ec) {
+   // Frame thumbnails, optionally stored at ingest
+
+   try {
+      spdlog::info("Updating DB schema");
+
+      sqlite_burrito::statement::execute(db.get_connection(), R"sql(
+CREATE TABLE IF NOT EXISTS thumbnails (
+   frame_number INTEGER PRIMARY KEY NOT NULL,
+   width INT NOT NULL,
+   height INT NOT NULL,
+   frame_width INT NOT NULL,
+   frame_height INT NOT NULL,
+   image BLOB NOT NULL
+);
+)sql");
+
+      spdlog::info("Migration done!");
+   } catch (const std::system_error &e) {
+      spdlog::error("Database upgrade failed: {}", e.what());
+      ec = e.code();
+   } catch (...) {
+      spdlog::error("Database upgrade failed");
+      ec = std::make_error_code(std::errc::bad_message);
+   }
+}
+
+} // namespace
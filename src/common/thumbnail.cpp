@@ -0,0 +1,123 @@
+/**
+ * @file   thumbnail.cpp
+ * @author Dennis Sitelew
+ * @date   Oct. 18, 2026
+ */
+
+#include <ocs/common/thumbnail.h>
+
+// Note: static, the tools linking this library are including their own copy of stb_image
+#define STB_IMAGE_STATIC
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_ONLY_JPEG
+#include <stb_image.h>
+
+#define STB_IMAGE_WRITE_STATIC
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+namespace ocs::common {
+
+namespace {
+
+constexpr int num_channels = 3;
+
+//! Scale the image down, each target pixel is the average of the source pixels it covers
+std::vector<std::uint8_t> scale_down(const ffmpeg::decoder::frame &frame, int width, int height) {
+   const auto src_stride = static_cast<std::size_t>(frame.width) * num_channels;
+
+   std::vector<std::uint8_t> result(static_cast<std::size_t>(width) * height * num_channels);
+   auto *target = result.data();
+
+   for (int y = 0; y < height; ++y) {
+      const auto src_top = static_cast<std::int64_t>(y) * frame.height / height;
+      const auto src_bottom = std::max(static_cast<std::int64_t>(y + 1) * frame.height / height, src_top + 1);
+
+      for (int x = 0; x < width; ++x) {
+         const auto src_left = static_cast<std::int64_t>(x) * frame.width / width;
+         const auto src_right = std::max(static_cast<std::int64_t>(x + 1) * frame.width / width, src_left + 1);
+
+         std::uint32_t sums[num_channels] = {};
+         for (auto src_y = src_top; src_y < src_bottom; ++src_y) {
+            const auto *row = frame.data.data() + static_cast<std::size_t>(src_y) * src_stride;
+            for (auto src_x = src_left; src_x < src_right; ++src_x) {
+               for (int c = 0; c < num_channels; ++c) {
+                  sums[c] += row[src_x * num_channels + c];
+               }
+            }
+         }
+
+         const auto count = static_cast<std::uint32_t>((src_bottom - src_top) * (src_right - src_left));
+         for (int c = 0; c < num_channels; ++c) {
+            *target++ = static_cast<std::uint8_t>((sums[c] + count / 2) / count);
+         }
+      }
+   }
+
+   return result;
+}
+
+} // namespace
+
+thumbnail make_thumbnail(const ffmpeg::decoder::frame &frame, int max_size, int quality) {
+   if (frame.width <= 0 || frame.height <= 0 || max_size <= 0) {
+      throw std::invalid_argument("Invalid frame or thumbnail size");
+   }
+
+   thumbnail result;
+   result.frame_number = frame.frame_number;
+   result.frame_width = frame.width;
+   result.frame_height = frame.height;
+
+   // Keep the aspect ratio, the longer side is scaled to the maximal size
+   const auto longer_side = std::max(frame.width, frame.height);
+   if (longer_side <= max_size) {
+      result.width = frame.width;
+      result.height = frame.height;
+   } else {
+      result.width = std::max(1, static_cast<int>(static_cast<std::int64_t>(frame.width) * max_size / longer_side));
+      result.height = std::max(1, static_cast<int>(static_cast<std::int64_t>(frame.height) * max_size / longer_side));
+   }
+
+   const auto pixels = scale_down(frame, result.width, result.height);
+
+   auto write_func = [](void *context, void *data, int size) {
+      auto &target = *static_cast<std::vector<std::uint8_t> *>(context);
+      const auto *bytes = static_cast<const std::uint8_t *>(data);
+      target.insert(std::end(target), bytes, bytes + size);
+   };
+
+   if (!stbi_write_jpg_to_func(write_func, &result.jpeg, result.width, result.height, num_channels, pixels.data(),
+                               std::clamp(quality, 1, 100))) {
+      throw std::runtime_error("Failed to encode the thumbnail");
+   }
+
+   return result;
+}
+
+std::optional<ffmpeg::decoder::frame> decode_thumbnail(const thumbnail &thumb) {
+   int width, height, channels;
+   std::unique_ptr<stbi_uc, decltype(&stbi_image_free)> pixels{
+       stbi_load_from_memory(thumb.jpeg.data(), static_cast<int>(thumb.jpeg.size()), &width, &height, &channels,
+                             num_channels),
+       &stbi_image_free};
+   if (!pixels) {
+      return std::nullopt;
+   }
+
+   ffmpeg::decoder::frame result;
+   result.frame_number = thumb.frame_number;
+   result.width = width;
+   result.height = height;
+   result.bytes_per_line = width * num_channels;
+
+   const auto size = static_cast<std::size_t>(result.bytes_per_line) * height;
+   result.data.assign(pixels.get(), pixels.get() + size);
+   return result;
+}
+
+} // namespace ocs::common
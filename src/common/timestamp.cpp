@@ -0,0 +1,62 @@
+/**
+ * @file   timestamp.cpp
+ * @author Dennis Sitelew
+ * @date   Oct. 18, 2026
+ */
+
+#include <ocs/common/timestamp.h>
+
+#include <boost/filesystem/path.hpp>
+
+#include <cstdio>
+
+namespace ocs::common::timestamp {
+
+std::optional<std::chrono::milliseconds> start_time_for_video(const std::string &video_file) {
+   const auto base_name = boost::filesystem::path(video_file).stem().string();
+
+   // Matches the video_file_name_format, anything after the time is ignored
+   int year, month, day, hour, minute, second;
+   const auto num_parsed =
+       std::sscanf(base_name.c_str(), "%4d-%2d-%2d %2d-%2d-%2d", &year, &month, &day, &hour, &minute, &second);
+   if (num_parsed != 6) {
+      return std::nullopt;
+   }
+
+   const bool valid_date = month >= 1 && month <= 12 && day >= 1 && day <= 31;
+   const bool valid_time = hour >= 0 && hour < 24 && minute >= 0 && minute < 60 && second >= 0 && second < 61;
+   if (!valid_date || !valid_time) {
+      return std::nullopt;
+   }
+
+   using namespace std::chrono;
+   const auto days = days_from_civil(year, static_cast<unsigned>(month), static_cast<unsigned>(day));
+   const auto total = hours{days * 24 + hour} + minutes{minute} + seconds{second};
+   return duration_cast<milliseconds>(total);
+}
+
+std::int64_t days_from_civil(int year, unsigned month, unsigned day) {
+   // http://howardhinnant.github.io/date_algorithms.html#days_from_civil
+   year -= month <= 2 ? 1 : 0;
+   const std::int64_t era = (year >= 0 ? year : year - 399) / 400;
+   const auto year_of_era = static_cast<unsigned>(year - era * 400);
+   const unsigned day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+   const unsigned day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+   return era * 146097 + static_cast<std::int64_t>(day_of_era) - 719468;
+}
+
+civil_date civil_from_days(std::int64_t days) {
+   // http://howardhinnant.github.io/date_algorithms.html#civil_from_days
+   days += 719468;
+   const std::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+   const auto day_of_era = static_cast<unsigned>(days - era * 146097);
+   const unsigned year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+   const unsigned day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+   const unsigned month_index = (5 * day_of_year + 2) / 153;
+   const unsigned day = day_of_year - (153 * month_index + 2) / 5 + 1;
+   const unsigned month = month_index < 10 ? month_index + 3 : month_index - 9;
+   const auto year = static_cast<int>(static_cast<std::int64_t>(year_of_era) + era * 400 + (month <= 2 ? 1 : 0));
+   return {year, month, day};
+}
+
+} // namespace ocs::common::timestamp
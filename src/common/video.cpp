@@ -47,6 +47,18 @@ std::optional<std::int64_t> video::frame_count() const {
    return decoder_.frame_count();
 }
 
+std::optional<std::chrono::milliseconds> video::duration() const {
+   return decoder_.duration();
+}
+
+double video::frame_rate() const {
+   return decoder_.frame_rate();
+}
+
+std::pair<int, int> video::time_base() const {
+   return decoder_.time_base();
+}
+
 std::chrono::seconds video::frame_number_to_seconds(std::int64_t num) const {
    return decoder_.frame_number_to_seconds(num);
 }
@@ -7,6 +7,8 @@
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+
 using namespace ocs::ffmpeg;
 
 namespace {
@@ -77,8 +79,15 @@ public:
 
    double frame_ratio{0.0};
    double time_ratio{0.0};
+   AVRational time_base{0, 1};
 
    traits::frame rgb_frame;
+
+   //! Number of the last frame received from the codec since the last seek, -1 if none
+   std::int64_t last_frame{-1};
+
+   //! Set once the end of the file was reached, the decoder has to be flushed before it could be used again
+   bool drained{false};
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -141,6 +150,7 @@ decoder::decoder(std::string video_path, frame_filter filter, frame_cb_t cb, std
    // Seek to the starting frame
    ffmpeg_->frame_ratio = av_q2d(video_stream->avg_frame_rate);
    ffmpeg_->time_ratio = av_q2d(video_stream->time_base);
+   ffmpeg_->time_base = video_stream->time_base;
 
    seek_to_closest_frame(0, starting_frame, 0);
    auto frame_count = static_cast<std::int64_t>((static_cast<double>(ffmpeg_->input_ctx->duration) / AV_TIME_BASE) *
@@ -163,6 +173,22 @@ std::chrono::milliseconds decoder::frame_number_to_milliseconds(std::int64_t fra
    return std::chrono::milliseconds{static_cast<std::int64_t>(fractional_milliseconds)};
 }
 
+double decoder::frame_rate() const {
+   return ffmpeg_->frame_ratio;
+}
+
+std::pair<int, int> decoder::time_base() const {
+   return {ffmpeg_->time_base.num, ffmpeg_->time_base.den};
+}
+
+std::optional<std::chrono::milliseconds> decoder::duration() const {
+   const auto duration = ffmpeg_->input_ctx->duration;
+   if (duration == AV_NOPTS_VALUE || duration <= 0) {
+      return std::nullopt;
+   }
+   return std::chrono::milliseconds{av_rescale(duration, 1000, AV_TIME_BASE)};
+}
+
 std::chrono::seconds decoder::frame_number_to_seconds(std::int64_t frame_number) const {
    return std::chrono::duration_cast<std::chrono::seconds>(frame_number_to_milliseconds(frame_number));
 }
@@ -210,24 +236,60 @@ void decoder::seek_to_closest_frame(std::int64_t min_frame, std::int64_t max_fra
    }
 }
 
-void decoder::convert_to_rgb_and_copy_data(const AVFrame &src, std::vector<std::uint8_t> &target) const {
+void decoder::seek(std::int64_t frame_number) {
+   starting_frame_ = frame_number;
+   if (can_decode_forward_to(frame_number)) {
+      // Decoding the few frames in between is cheaper than decoding from the keyframe again
+      return;
+   }
+
+   // Drop the frames buffered by the decoder (and leave the draining mode, if the end of the file was reached)
+   avcodec_flush_buffers(ffmpeg_->decoder_ctx);
+   ffmpeg_->last_frame = -1;
+   ffmpeg_->drained = false;
+
+   seek_to_closest_frame(0, frame_number, 0);
+}
+
+bool decoder::can_decode_forward_to(std::int64_t frame_number) const {
+   const auto last_frame = ffmpeg_->last_frame;
+   if (ffmpeg_->drained || last_frame < 0 || frame_number <= last_frame) {
+      return false;
+   }
+
+   auto *video_stream = ffmpeg_->input_ctx->streams[ffmpeg_->video_stream_idx];
+   const auto *keyframe = avformat_index_get_entry_from_timestamp(
+       video_stream, frame_number_to_timestamp(frame_number), AVSEEK_FLAG_BACKWARD);
+   if (keyframe) {
+      // No keyframe between the last decoded frame and the requested one
+      return keyframe->timestamp <= frame_number_to_timestamp(last_frame);
+   }
+
+   return frame_number - last_frame <= max_forward_decode;
+}
+
+void decoder::convert_to_rgb_and_copy_data(const AVFrame &src,
+                                           int width,
+                                           int height,
+                                           std::vector<std::uint8_t> &target) const {
    auto &rgb = *ffmpeg_->rgb_frame;
    rgb.format = AV_PIX_FMT_RGB24;
-   rgb.width = src.width;
-   rgb.height = src.height;
+   rgb.width = width;
+   rgb.height = height;
 
    const auto av_format = [](auto fmt) { return static_cast<AVPixelFormat>(fmt); };
 
-   int ret = av_image_alloc(rgb.data, rgb.linesize, src.width, src.height, av_format(rgb.format), 1);
+   int ret = av_image_alloc(rgb.data, rgb.linesize, rgb.width, rgb.height, av_format(rgb.format), 1);
    if (ret < 0) {
       throw std::runtime_error("Could not allocate destination image");
    }
 
    auto &sws_context = ffmpeg_->sws_context;
 
-   // Convert the image from its native format to RGB
+   // Convert the image from its native format to RGB, averaging the pixels if it's scaled down
+   const bool is_scaled = (rgb.width != src.width || rgb.height != src.height);
    sws_context = sws_getCachedContext(sws_context, src.width, src.height, av_format(src.format), rgb.width, rgb.height,
-                                      av_format(rgb.format), 0, nullptr, nullptr, nullptr);
+                                      av_format(rgb.format), is_scaled ? SWS_AREA : 0, nullptr, nullptr, nullptr);
    sws_scale(sws_context, static_cast<const uint8_t *const *>(src.data), src.linesize, 0, src.height, rgb.data,
              rgb.linesize);
 
@@ -243,30 +305,52 @@ void decoder::convert_to_rgb_and_copy_data(const AVFrame &src, std::vector<std::
    av_freep(&rgb.data);
 }
 
-void decoder::to_frame(const AVFrame &src, std::int64_t frame_number, frame &target) const {
+void decoder::to_frame(const AVFrame &src,
+                       std::int64_t frame_number,
+                       frame &target,
+                       int max_width,
+                       int max_height) const {
    target.frame_number = frame_number;
+   target.frame_width = src.width;
+   target.frame_height = src.height;
    target.width = src.width;
    target.height = src.height;
-   convert_to_rgb_and_copy_data(src, target.data);
+
+   if (max_width > 0 && max_height > 0 && (src.width > max_width || src.height > max_height)) {
+      // The side which is relatively longer is fitted, the other one is scaled proportionally
+      if (src.width * max_height > src.height * max_width) {
+         target.width = max_width;
+         target.height = std::max(src.height * max_width / src.width, 1);
+      } else {
+         target.width = std::max(src.width * max_height / src.height, 1);
+         target.height = max_height;
+      }
+   }
+
+   convert_to_rgb_and_copy_data(src, target.width, target.height, target.data);
    target.bytes_per_line = ffmpeg_->rgb_frame->linesize[0];
 }
 
 bool decoder::handle_decoded_frames(const AVPacket *packet) const {
    auto &decoder_ctx = ffmpeg_->decoder_ctx;
 
-   int ret = avcodec_send_packet(decoder_ctx, packet);
+   const int ret = avcodec_send_packet(decoder_ctx, packet);
    if (ret < 0) {
       spdlog::error("Error sending a packet for decoding: {}", ret);
       return false;
    }
 
-   traits::frame rgb_frame;
+   return receive_decoded_frames();
+}
+
+bool decoder::receive_decoded_frames() const {
+   auto &decoder_ctx = ffmpeg_->decoder_ctx;
 
    while (true) {
       traits::frame frame;
       traits::frame sw_frame;
 
-      ret = avcodec_receive_frame(decoder_ctx, frame);
+      const int ret = avcodec_receive_frame(decoder_ctx, frame);
       if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
          return true;
       }
@@ -276,6 +360,10 @@ bool decoder::handle_decoded_frames(const AVPacket *packet) const {
          return false;
       }
 
+      const auto frame_number =
+          static_cast<std::int64_t>(static_cast<double>(frame->pts) * ffmpeg_->time_ratio * ffmpeg_->frame_ratio);
+      ffmpeg_->last_frame = frame_number;
+
       const auto frame_mask = static_cast<int>(picture_type_to_filter(frame->pict_type));
       const auto filter_mask = static_cast<int>(filter_);
       if ((frame_mask & filter_mask) == 0) {
@@ -295,9 +383,6 @@ bool decoder::handle_decoded_frames(const AVPacket *packet) const {
          tmp_frame = frame.get();
       }
 
-      const auto frame_number =
-          static_cast<std::int64_t>(static_cast<double>(frame->pts) * ffmpeg_->time_ratio * ffmpeg_->frame_ratio);
-
       if (frame_number < starting_frame_) {
          // We weren't able to seek to the frame itself, so we have to skip some frames before it
          continue;
@@ -311,7 +396,8 @@ bool decoder::handle_decoded_frames(const AVPacket *packet) const {
 }
 
 void decoder::run() const {
-   bool can_run = true;
+   // The frames left in the decoder by the previous run come first, when decoding forward
+   bool can_run = receive_decoded_frames();
 
    traits::packet packet;
    while (can_run) {
@@ -328,6 +414,7 @@ void decoder::run() const {
 
    // flush the decoder
    if (can_run) {
+      ffmpeg_->drained = true;
       if (!handle_decoded_frames(nullptr)) {
          spdlog::warn("Could not flush the frames");
       }
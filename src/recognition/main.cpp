@@ -2,6 +2,7 @@
 
 #include <ocs/common/database.h>
 
+#include <ocs/common/timestamp.h>
 #include <ocs/common/video.h>
 #include <ocs/recognition/bmp.h>
 #include <ocs/recognition/ocr.h>
@@ -14,6 +15,7 @@
 #include <memory>
 #include <system_error>
 #include <thread>
+#include <tuple>
 
 #include <spdlog/spdlog.h>
 #include <boost/asio/io_context.hpp>
@@ -54,6 +56,11 @@ int main(int argc, const char **argv) {
    const auto &options = pres.value();
 
    database db{options.database_file};
+
+   database::span_options span_opts{};
+   span_opts.max_frame_gap = options.span_gap;
+   db.set_span_options(span_opts);
+
    auto queue = std::make_shared<video::queue_t>(options.ocr_threads * 2);
 
    /// --- Setup the progress reporters ---
@@ -63,6 +70,16 @@ int main(int argc, const char **argv) {
                                  static_cast<ocs::ffmpeg::decoder::frame_filter>(options.frame_filter), queue,
                                  starting_frame_number};
 
+   {
+      database::video_info info{};
+      info.frame_rate = video_file.frame_rate();
+      std::tie(info.time_base_num, info.time_base_den) = video_file.time_base();
+      info.duration = video_file.duration();
+      info.frame_count = video_file.frame_count();
+      info.start_time = timestamp::start_time_for_video(options.video_file);
+      db.store_video_info(info);
+   }
+
    std::string postfix = "Processing ...";
 
    using namespace indicators;
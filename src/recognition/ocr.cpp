@@ -2,6 +2,7 @@
 // Created by Dennis Sitelew on 21.12.22.
 //
 
+#include <ocs/common/thumbnail.h>
 #include <ocs/config.h>
 #include <ocs/recognition/bmp.h>
 #include <ocs/recognition/ocr.h>
@@ -71,7 +72,12 @@ void ocr::start(const value_queue_ptr_t &queue, const ocr_filter_cb_t &filter) c
       }
 
       if (filter(frame->frame_number)) {
-         if (const auto result = provider_->do_ocr(*frame)) {
+         if (auto result = provider_->do_ocr(*frame)) {
+            // Made from the same decoded frame, while it's still owned by this thread
+            const bool wants_thumbnail = opts_->thumbnail_all_frames || !result->entries.empty();
+            if (opts_->thumbnail_size > 0 && wants_thumbnail) {
+               result->preview = common::make_thumbnail(*frame, opts_->thumbnail_size, opts_->thumbnail_quality);
+            }
             cb_(*result);
          }
       }
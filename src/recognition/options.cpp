@@ -4,6 +4,7 @@
 
 #include <ocs/recognition/options.h>
 
+#include <ocs/common/database.h>
 #include <ocs/ffmpeg/decoder.h>
 
 #include <boost/filesystem.hpp>
@@ -35,6 +36,7 @@ std::optional<options> options::parse(int argc, const char **argv) {
    res.ocr_threads = std::thread::hardware_concurrency();
    res.frame_filter = static_cast<std::uint16_t>(ffmpeg::decoder::frame_filter::I_and_P);
    res.tesseract.data_path = get_default_tess_data_path(argv[0]);
+   res.span_gap = common::database::span_options{}.max_frame_gap;
 
    bool show_help{false};
 
@@ -66,6 +68,26 @@ std::optional<options> options::parse(int argc, const char **argv) {
                                .name("--save-bitmaps")
                                .help("Save video bitmaps in the out/ subdirectory"));
 
+   res.global.add_argument(lyra::opt(res.span_gap, "span_gap")
+                               .name("-g")
+                               .name("--span-gap")
+                               .help("Maximal distance in frames between two appearances of the same text at the same "
+                                     "position, for them to be stored as a single span"));
+
+   res.global.add_argument(lyra::opt(res.thumbnail_size, "thumbnail_size")
+                               .name("-t")
+                               .name("--thumbnail-size")
+                               .help("Store JPEG thumbnails of the frames with text in the database, at most "
+                                     "thumbnail_size pixels wide and high. No thumbnails are stored by default"));
+
+   res.global.add_argument(lyra::opt(res.thumbnail_quality, "quality")
+                               .name("--thumbnail-quality")
+                               .help("JPEG quality of the thumbnails, from 1 to 100. The default is 75"));
+
+   res.global.add_argument(lyra::opt(res.thumbnail_all_frames)
+                               .name("--thumbnail-all-frames")
+                               .help("Store the thumbnails of all the processed frames, including the ones without text"));
+
    res.global.add_argument(lyra::help(show_help));
 
    res.subcommands.require(1, 1);
@@ -93,6 +115,11 @@ std::optional<options> options::parse(int argc, const char **argv) {
    }
 #endif // OCS_VISION_KIT_SUPPORT()
 
+   if (res.thumbnail_size < 0 || res.thumbnail_quality < 1 || res.thumbnail_quality > 100) {
+      std::cerr << "Invalid thumbnail size or quality" << std::endl;
+      return std::nullopt;
+   }
+
    if (!boost::filesystem::exists(res.video_file)) {
       std::cerr << "Video file does not exist: " << res.video_file << std::endl;
       return std::nullopt;
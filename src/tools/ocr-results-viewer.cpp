@@ -8,6 +8,7 @@
 #define STB_IMAGE_IMPLEMENTATION
 
 #include <ocs/common/ocr_result.h>
+#include <ocs/viewer/render/texture.h>
 #include <ocs/viewer/render/window.h>
 #include <ocs/viewer/views/util.h>
 
@@ -43,52 +44,6 @@ ImVec2 operator/(const ImVec2 &lhs, const float rhs) {
    return {lhs.x / rhs, lhs.y / rhs};
 }
 
-struct texture {
-   texture(const std::uint8_t *data, const int width, const int height)
-      : width{width}
-      , height{height}
-
-   {
-      // Create a OpenGL texture identifier
-      glGenTextures(1, &handle);
-      glBindTexture(GL_TEXTURE_2D, handle);
-
-      // Setup filtering parameters for display
-      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-      // This is required on WebGL for non power-of-two textures
-      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-      // Upload pixels into texture
-#if defined(GL_UNPACK_ROW_LENGTH) && !defined(__EMSCRIPTEN__)
-      glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-#endif
-      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-
-      GLenum ec;
-      while ((ec = glad_glGetError()) != GL_NO_ERROR) {
-         spdlog::warn("OpenGL error inside {}: 0x{:x}", "texture()", ec);
-      }
-   }
-
-   ~texture() {
-      if (handle != 0) {
-         glDeleteTextures(1, &handle);
-      }
-   }
-
-   [[nodiscard]] float fwidth() const { return static_cast<float>(width); }
-
-   [[nodiscard]] float fheight() const { return static_cast<float>(height); }
-
-public:
-   GLuint handle{0};
-   int width;
-   int height;
-};
-
 struct options {
    static std::optional<options> parse(int argc, const char **argv) {
       auto cli = lyra::cli{};
@@ -207,13 +162,15 @@ private:
    }
 
    void load_image() {
+      // Note: the texture is RGB, so the alpha channel (if any) is dropped
       int x, y, n;
-      const auto data = stbi_load(opts_.image_file.c_str(), &x, &y, &n, 0);
+      const auto data = stbi_load(opts_.image_file.c_str(), &x, &y, &n, 3);
       if (data == nullptr) {
          throw std::runtime_error(fmt::format("Failed to load image: {}", stbi_failure_reason()));
       }
 
-      texture_ = std::make_unique<texture>(data, x, y);
+      texture_ = std::make_unique<texture>();
+      texture_->update(data, x, y);
 
       stbi_image_free(data);
    }
@@ -274,7 +231,8 @@ private:
       const auto cursor_pos = ImGui::GetCursorScreenPos();
       const auto draw_list = ImGui::GetForegroundDrawList();
 
-      ImGui::Image(reinterpret_cast<void *>(texture_->handle), ImVec2(texture_->fwidth(), texture_->fheight()));
+      const ImVec2 image_size{static_cast<float>(texture_->width()), static_cast<float>(texture_->height())};
+      ImGui::Image(reinterpret_cast<void *>(texture_->handle()), image_size);
 
       handle_drag();
       handle_selection_change(image_region);
@@ -0,0 +1,142 @@
+/**
+ * @file   ocs-merge.cpp
+ * @author Dennis Sitelew
+ * @date   Oct. 18, 2026
+ */
+
+#include "tool_common.h"
+
+#include <ocs/common/archive.h>
+
+#include <spdlog/spdlog.h>
+#include <boost/filesystem.hpp>
+#include <lyra/lyra.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace fs = boost::filesystem;
+
+namespace ocs::merge {
+
+struct options {
+   static std::optional<options> parse(int argc, const char **argv) {
+      auto cli = lyra::cli{};
+
+      options result{};
+
+      cli.add_argument(lyra::help(result.show_help));
+      cli.add_argument(lyra::opt(result.archive_file, "archive_file")
+                           .name("-o")
+                           .name("--archive")
+                           .required()
+                           .help("Archive database to merge the OCR databases into"));
+      cli.add_argument(lyra::opt(result.video_extension, "video_ext")
+                           .name("-v")
+                           .name("--video-ext")
+                           .required()
+                           .help("Video file extension, e.g.: .mkv"));
+      cli.add_argument(lyra::opt(result.db_extension, "db_ext")
+                           .name("-d")
+                           .name("--db-ext")
+                           .help("Database file extension, used when searching for databases in directories"));
+      cli.add_argument(lyra::arg(result.paths, "paths")
+                           .cardinality(1, std::numeric_limits<std::size_t>::max())
+                           .required()
+                           .help("OCR database files or directories containing OCR database files"));
+
+      if (!tools::parse_command_line(cli, result.show_help, argc, argv)) {
+         return std::nullopt;
+      }
+
+      return result;
+   }
+
+   std::vector<std::string> paths{};
+   std::string archive_file{};
+   std::string video_extension{};
+   std::string db_extension{".db"};
+
+   //! Only the usage was requested, nothing to do
+   bool show_help{false};
+};
+
+std::vector<std::string> collect_databases(const options &opts) {
+   auto result = tools::collect_databases(opts.paths, opts.db_extension);
+
+   // Don't merge the archive into itself
+   const auto archive_path = fs::weakly_canonical(opts.archive_file);
+   result.erase(std::remove_if(std::begin(result), std::end(result),
+                               [&](const auto &p) { return fs::weakly_canonical(p) == archive_path; }),
+                std::end(result));
+
+   std::sort(std::begin(result), std::end(result));
+   return result;
+}
+
+} // namespace ocs::merge
+
+int main_checked(int argc, const char **argv) {
+   using namespace ocs::merge;
+   using merge_result = ocs::common::archive::merge_result;
+
+   const auto maybe_options = options::parse(argc, argv);
+   if (!maybe_options) {
+      return EXIT_FAILURE;
+   }
+
+   const auto &opts = *maybe_options;
+   if (opts.show_help) {
+      return EXIT_SUCCESS;
+   }
+
+   const auto databases = collect_databases(opts);
+
+   ocs::common::archive archive{opts.archive_file};
+
+   std::size_t num_merged{0};
+   std::size_t num_unchanged{0};
+   std::size_t num_outdated{0};
+   std::size_t num_failed{0};
+
+   for (const auto &db_path : databases) {
+      auto video_path = fs::path{db_path};
+      video_path.replace_extension(opts.video_extension);
+
+      try {
+         switch (archive.merge(db_path, video_path.string())) {
+            case merge_result::merged:
+               spdlog::info("Merged {}", db_path);
+               ++num_merged;
+               break;
+
+            case merge_result::unchanged:
+               spdlog::debug("Unchanged {}", db_path);
+               ++num_unchanged;
+               break;
+
+            case merge_result::outdated:
+               spdlog::warn("Skipping {}, it has to be migrated with ocs-migrate first", db_path);
+               ++num_outdated;
+               break;
+         }
+      } catch (const std::exception &e) {
+         spdlog::error("Error merging {}: {}", db_path, e.what());
+         ++num_failed;
+      }
+   }
+
+   spdlog::info("{} merged, {} unchanged, {} skipped, {} failed", num_merged, num_unchanged, num_outdated,
+                num_failed);
+
+   return num_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int argc, char **argv) {
+   return ocs::tools::run_main(argc, argv, main_checked);
+}
@@ -0,0 +1,165 @@
+/**
+ * @file   ocs-migrate.cpp
+ * @author Dennis Sitelew
+ * @date   Oct. 18, 2026
+ */
+
+#include "tool_common.h"
+
+#include <ocs/common/database.h>
+
+#include <spdlog/spdlog.h>
+#include <boost/filesystem.hpp>
+#include <lyra/lyra.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = boost::filesystem;
+
+namespace ocs::migrate {
+
+struct options {
+   static std::optional<options> parse(int argc, const char **argv) {
+      auto cli = lyra::cli{};
+
+      options result{};
+      result.num_threads = std::max(std::thread::hardware_concurrency(), 1U);
+
+      cli.add_argument(lyra::help(result.show_help));
+      cli.add_argument(lyra::opt(result.num_threads, "num_threads")
+                           .name("-p")
+                           .name("--num-threads")
+                           .help("Number of databases to migrate in parallel"));
+      cli.add_argument(lyra::opt(result.db_extension, "db_ext")
+                           .name("-d")
+                           .name("--db-ext")
+                           .help("Database file extension, used when searching for databases in directories"));
+      cli.add_argument(lyra::opt([&](bool) { result.vacuum = false; })
+                           .name("--no-vacuum")
+                           .help("Do not rebuild the database files after the migration"));
+      cli.add_argument(lyra::arg(result.paths, "paths")
+                           .cardinality(1, std::numeric_limits<std::size_t>::max())
+                           .required()
+                           .help("Database files or directories containing database files"));
+
+      if (!tools::parse_command_line(cli, result.show_help, argc, argv)) {
+         return std::nullopt;
+      }
+
+      if (result.show_help) {
+         return result;
+      }
+
+      if (result.num_threads == 0) {
+         std::cerr << "Number of threads should be positive" << std::endl;
+         return std::nullopt;
+      }
+
+      return result;
+   }
+
+   std::vector<std::string> paths{};
+   std::string db_extension{".db"};
+   unsigned num_threads{1};
+   bool vacuum{true};
+
+   //! Only the usage was requested, nothing to do
+   bool show_help{false};
+};
+
+std::vector<std::string> collect_databases(const options &opts) {
+   auto result = tools::collect_databases(opts.paths, opts.db_extension);
+
+   // Start with the biggest files, so that a single huge database doesn't end up being the last one to start
+   std::sort(std::begin(result), std::end(result),
+             [](const auto &lhs, const auto &rhs) { return fs::file_size(lhs) > fs::file_size(rhs); });
+
+   return result;
+}
+
+} // namespace ocs::migrate
+
+int main_checked(int argc, const char **argv) {
+   using namespace ocs::migrate;
+
+   const auto maybe_options = options::parse(argc, argv);
+   if (!maybe_options) {
+      return EXIT_FAILURE;
+   }
+
+   const auto &opts = *maybe_options;
+   if (opts.show_help) {
+      return EXIT_SUCCESS;
+   }
+
+   const auto databases = collect_databases(opts);
+
+   spdlog::info("Migrating {} databases using {} threads", databases.size(), opts.num_threads);
+
+   std::atomic<std::size_t> next_idx{0};
+   std::atomic<std::size_t> num_failed{0};
+
+   std::mutex totals_mutex;
+   std::uintmax_t total_before{0};
+   std::uintmax_t total_after{0};
+
+   auto worker = [&] {
+      while (true) {
+         const auto idx = next_idx++;
+         if (idx >= databases.size()) {
+            return;
+         }
+
+         const auto &path = databases[idx];
+         try {
+            const auto size_before = fs::file_size(path);
+            spdlog::info("Migrating {}", path);
+
+            // Opening a database is enough to run all the pending migrations
+            ocs::common::database db{path};
+            if (opts.vacuum) {
+               db.vacuum();
+            }
+
+            const auto size_after = fs::file_size(path);
+            spdlog::info("Done {}: {:.2f} MiB -> {:.2f} MiB", path, static_cast<double>(size_before) / (1024.0 * 1024.0),
+                         static_cast<double>(size_after) / (1024.0 * 1024.0));
+
+            std::lock_guard lock{totals_mutex};
+            total_before += size_before;
+            total_after += size_after;
+         } catch (const std::exception &e) {
+            spdlog::error("Error migrating {}: {}", path, e.what());
+            ++num_failed;
+         }
+      }
+   };
+
+   std::vector<std::thread> workers;
+   const auto num_workers = std::min<std::size_t>(opts.num_threads, databases.size());
+   for (std::size_t i = 0; i < num_workers; ++i) {
+      workers.emplace_back(worker);
+   }
+
+   for (auto &w : workers) {
+      w.join();
+   }
+
+   spdlog::info("Total: {:.2f} MiB -> {:.2f} MiB, {} failed", static_cast<double>(total_before) / (1024.0 * 1024.0),
+                static_cast<double>(total_after) / (1024.0 * 1024.0), num_failed.load());
+
+   return num_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int argc, char **argv) {
+   return ocs::tools::run_main(argc, argv, main_checked);
+}
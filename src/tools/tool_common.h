@@ -0,0 +1,81 @@
+/**
+ * @file   tool_common.h
+ * @author Dennis Sitelew
+ * @date   Oct. 18, 2026
+ */
+#pragma once
+
+#include <spdlog/spdlog.h>
+#include <boost/filesystem.hpp>
+#include <lyra/lyra.hpp>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//! Command line handling shared by the tools working on many OCR databases at once
+namespace ocs::tools {
+
+/**
+ * Parse the command line. The usage is printed if the command line is invalid, or if it was requested.
+ *
+ * @param show_help Flag bound to lyra::help
+ * @return false if the command line is invalid
+ */
+inline bool parse_command_line(const lyra::cli &cli, const bool &show_help, int argc, const char **argv) {
+   if (const auto parse_result = cli.parse({argc, argv}); !parse_result) {
+      std::cerr << "Error in command line: " << parse_result.message() << std::endl;
+      std::cerr << cli << std::endl;
+      return false;
+   }
+
+   if (show_help) {
+      std::cerr << cli << std::endl;
+   }
+
+   return true;
+}
+
+//! @return Database files given directly, and the ones with the given extension found in the given directories
+inline std::vector<std::string> collect_databases(const std::vector<std::string> &paths,
+                                                  const std::string &db_extension) {
+   namespace fs = boost::filesystem;
+
+   std::vector<std::string> result;
+
+   for (const auto &path : paths) {
+      if (fs::is_directory(path)) {
+         for (const auto &entry : fs::directory_iterator(path)) {
+            if (fs::is_regular_file(entry.status()) && entry.path().extension() == db_extension) {
+               result.push_back(entry.path().string());
+            }
+         }
+      } else if (fs::is_regular_file(path)) {
+         result.push_back(path);
+      } else {
+         spdlog::warn("Skipping {}: not a file or directory", path);
+      }
+   }
+
+   return result;
+}
+
+//! Run the tool, reporting the escaped exceptions as failures
+template <typename Main>
+int run_main(int argc, char **argv, Main &&main_checked) {
+   try {
+      spdlog::set_pattern("[%^%L%$][%t] %v");
+
+      // srsly msvc, const cast?
+      return main_checked(argc, const_cast<const char **>(argv));
+   } catch (const std::exception &e) {
+      std::cerr << "Error: " << e.what() << std::endl;
+      return EXIT_FAILURE;
+   } catch (...) {
+      std::cerr << "Unknown error" << std::endl;
+      return EXIT_FAILURE;
+   }
+}
+
+} // namespace ocs::tools
@@ -6,7 +6,7 @@
 #error Internal use only
 #endif
 
-const int ocs::viewer::results::CURRENT_DB_VERSION = 1;
+const int ocs::viewer::results::CURRENT_DB_VERSION = 2;
 
 inline void ocs::viewer::results::db_update(sqlite_burrito::versioned_database &db, int from, std::error_code &ec) {
    spdlog::trace("Updating database: from version {}", from);
@@ -16,6 +16,10 @@ inline void ocs::viewer::results::db_update(sqlite_burrito::versioned_database &
          update_v0(db);
          return;
 
+      case 1:
+         update_v1(db);
+         return;
+
       default:
          ec = std::make_error_code(std::errc::invalid_argument);
    }
@@ -0,0 +1,23 @@
+//
+// Created by Dennis Sitelew on 18.10.26.
+//
+
+#ifndef OCS_VIEWER_IDL_INCLUDE
+#error Internal use only
+#endif
+
+namespace {
+
+void update_v1(sqlite_burrito::versioned_database &db) {
+   auto sql = R"sql(
+BEGIN TRANSACTION;
+
+ALTER TABLE results
+ADD COLUMN last_frame_number INT NOT NULL DEFAULT(0);
+
+COMMIT;
+)sql";
+   sqlite_burrito::statement::execute(db.get_connection(), sql);
+}
+
+} // namespace
@@ -0,0 +1,184 @@
+/**
+ * @file   directory_watcher.cpp
+ * @author Dennis Sitelew
+ * @date   Oct. 18, 2026
+ */
+
+#include <ocs/common/database.h>
+#include <ocs/config.h>
+#include <ocs/viewer/directory_watcher.h>
+
+#include <boost/filesystem.hpp>
+#include <spdlog/spdlog.h>
+
+#if OCS_INOTIFY_SUPPORT()
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+#endif // OCS_INOTIFY_SUPPORT()
+
+using namespace ocs::viewer;
+
+namespace fs = boost::filesystem;
+
+directory_watcher::directory_watcher(std::string path,
+                                     std::string extension,
+                                     std::chrono::milliseconds interval,
+                                     changed_cb_t cb)
+   : path_{std::move(path)}
+   , extension_{std::move(extension)}
+   , interval_{interval}
+   , cb_{std::move(cb)}
+   , thread_([this]() { thread_func(); }) {
+   // Nothing to do here
+}
+
+directory_watcher::~directory_watcher() {
+   {
+      std::lock_guard lock{m_};
+      should_stop_ = true;
+   }
+   cv_.notify_one();
+   thread_.join();
+
+#if OCS_INOTIFY_SUPPORT()
+   if (notify_fd_ >= 0) {
+      close(notify_fd_);
+   }
+#endif // OCS_INOTIFY_SUPPORT()
+}
+
+void directory_watcher::thread_func() {
+   spdlog::trace("Starting directory watcher thread...");
+
+   if (!start_notifications()) {
+      files_ = list_files();
+   }
+
+   std::unique_lock lock{m_};
+   while (!cv_.wait_for(lock, interval_, [this] { return should_stop_; })) {
+      lock.unlock();
+
+      if (has_changes()) {
+         spdlog::trace("Files changed in {}", path_);
+         try {
+            cb_();
+         } catch (const std::exception &e) {
+            spdlog::error("Error handling the changed files in {}: {}", path_, e.what());
+         }
+      }
+
+      lock.lock();
+   }
+
+   spdlog::trace("Exiting directory watcher thread...");
+}
+
+bool directory_watcher::has_changes() {
+   if (notify_fd_ >= 0) {
+      return read_notifications();
+   }
+
+   auto files = list_files();
+   if (files == files_) {
+      return false;
+   }
+
+   files_ = std::move(files);
+   return true;
+}
+
+bool directory_watcher::start_notifications() {
+#if OCS_INOTIFY_SUPPORT()
+   notify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+   if (notify_fd_ < 0) {
+      spdlog::warn("Can't initialize inotify, polling {}: {}", path_, std::strerror(errno));
+      return false;
+   }
+
+   // Note: sqlite writes the changes into the database file itself, the journal files are filtered out by extension
+   const auto mask = IN_CREATE | IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE;
+   if (inotify_add_watch(notify_fd_, path_.c_str(), mask) < 0) {
+      // Most likely out of the watches limit, or the file system doesn't support it
+      spdlog::warn("Can't watch {} with inotify, polling it: {}", path_, std::strerror(errno));
+      close(notify_fd_);
+      notify_fd_ = -1;
+      return false;
+   }
+
+   spdlog::debug("Watching {} with inotify", path_);
+   return true;
+#else
+   spdlog::debug("Polling {} every {}ms", path_, interval_.count());
+   return false;
+#endif // OCS_INOTIFY_SUPPORT()
+}
+
+bool directory_watcher::read_notifications() {
+#if OCS_INOTIFY_SUPPORT()
+   bool changed = false;
+
+   alignas(inotify_event) std::array<char, 4096> buffer{};
+   while (true) {
+      const auto length = read(notify_fd_, buffer.data(), buffer.size());
+      if (length < 0 && errno == EINTR) {
+         continue;
+      }
+
+      // Note: the descriptor is non-blocking, so there is nothing left to read
+      if (length <= 0) {
+         break;
+      }
+
+      for (ssize_t pos = 0; pos < length;) {
+         const auto *event = reinterpret_cast<const inotify_event *>(buffer.data() + pos);
+         pos += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+         // Some events were dropped, so any of the files might have changed
+         if ((event->mask & IN_Q_OVERFLOW) != 0) {
+            changed = true;
+         } else if (event->len > 0 && is_watched(event->name)) {
+            changed = true;
+         }
+      }
+   }
+
+   return changed;
+#else
+   return false;
+#endif // OCS_INOTIFY_SUPPORT()
+}
+
+bool directory_watcher::is_watched(const std::string &file_name) const {
+   return fs::path{file_name}.extension() == extension_;
+}
+
+auto directory_watcher::list_files() const -> files_t {
+   files_t result;
+
+   // Note: the files might be created or removed while the directory is being listed
+   boost::system::error_code ec;
+   for (fs::directory_iterator it{path_, ec}, end; !ec && it != end; it.increment(ec)) {
+      const auto &path = it->path();
+      if (!is_watched(path.filename().string())) {
+         continue;
+      }
+
+      boost::system::error_code file_ec;
+      const auto size = fs::file_size(path, file_ec);
+      const auto mtime = file_ec ? std::time_t{} : fs::last_write_time(path, file_ec);
+      if (!file_ec) {
+         // Note: a span extended in place doesn't change the size, and the mtime might not change within a second
+         const auto change_counter = ocs::common::database::read_change_counter(path.string());
+         result[path.string()] = {size, mtime, change_counter};
+      }
+   }
+
+   if (ec) {
+      spdlog::warn("Error listing {}: {}", path_, ec.message());
+   }
+   return result;
+}
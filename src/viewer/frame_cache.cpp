@@ -0,0 +1,222 @@
+/**
+ * @file   frame_cache.cpp
+ * @author Dennis Sitelew
+ * @date   Oct. 18, 2026
+ */
+
+#include <ocs/viewer/frame_cache.h>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <functional>
+
+using namespace ocs::viewer;
+
+////////////////////////////////////////////////////////////////////////////////
+/// Struct: frame_cache::key_hash
+////////////////////////////////////////////////////////////////////////////////
+std::size_t frame_cache::key_hash::operator()(const key &k) const {
+   auto h = std::hash<std::string>{}(k.video_file);
+   const auto combine = [&h](std::size_t value) { h ^= value + 0x9e3779b9 + (h << 6) + (h >> 2); };
+
+   combine(std::hash<std::int64_t>{}(k.frame_number));
+   combine(std::hash<int>{}(k.max_width));
+   combine(std::hash<int>{}(k.max_height));
+   return h;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// Class: frame_cache
+////////////////////////////////////////////////////////////////////////////////
+frame_cache::frame_cache(std::size_t max_frames, thumbnail_source_t thumbnail_source)
+   : max_frames_{std::max<std::size_t>(max_frames, 1)}
+   , thumbnail_source_{std::move(thumbnail_source)}
+   , thread_([this]() { thread_func(); }) {
+   // Nothing to do here
+}
+
+frame_cache::~frame_cache() {
+   {
+      std::lock_guard lock{m_};
+      should_stop_ = true;
+   }
+   cv_.notify_one();
+   thread_.join();
+}
+
+auto frame_cache::get(const key &k) -> frame_ptr_t {
+   if (auto frame = find(k)) {
+      return frame;
+   }
+   return decode(k);
+}
+
+void frame_cache::request(const key &k) {
+   {
+      std::lock_guard lock{m_};
+      requested_ = k;
+   }
+   cv_.notify_one();
+}
+
+bool frame_cache::is_requested(const key &k) {
+   std::lock_guard lock{m_};
+   return requested_ == k || decoding_ == k;
+}
+
+void frame_cache::prefetch(std::vector<key> keys) {
+   {
+      std::lock_guard lock{m_};
+      pending_.assign(std::make_move_iterator(std::begin(keys)), std::make_move_iterator(std::end(keys)));
+   }
+   cv_.notify_one();
+}
+
+void frame_cache::thread_func() {
+   spdlog::trace("Starting frame prefetch thread...");
+   while (true) {
+      std::unique_lock lock{m_};
+      cv_.wait(lock, [this] { return should_stop_ || requested_ || !pending_.empty(); });
+      if (should_stop_) {
+         break;
+      }
+
+      key k;
+      if (requested_) {
+         k = std::move(requested_.value());
+         requested_.reset();
+      } else {
+         k = std::move(pending_.front());
+         pending_.pop_front();
+      }
+
+      if (by_key_.count(k) > 0) {
+         continue;
+      }
+
+      decoding_ = k;
+      lock.unlock();
+      decode(k);
+
+      lock.lock();
+      decoding_.reset();
+   }
+   spdlog::trace("Exiting frame prefetch thread...");
+}
+
+auto frame_cache::get_preview(const key &k) const -> std::optional<preview> {
+   if (!thumbnail_source_) {
+      return std::nullopt;
+   }
+
+   const auto thumb = thumbnail_source_(k);
+   if (!thumb) {
+      return std::nullopt;
+   }
+
+   auto image = ocs::common::decode_thumbnail(thumb.value());
+   if (!image) {
+      spdlog::warn("Failed to decode the thumbnail of frame {} of {}", k.frame_number, k.video_file);
+      return std::nullopt;
+   }
+
+   return preview{std::move(image.value()), thumb->frame_width, thumb->frame_height};
+}
+
+auto frame_cache::find(const key &k) -> frame_ptr_t {
+   std::lock_guard lock{m_};
+
+   auto it = by_key_.find(k);
+   if (it == by_key_.end()) {
+      return nullptr;
+   }
+
+   frames_.splice(frames_.begin(), frames_, it->second);
+   return it->second->second;
+}
+
+void frame_cache::store(const key &k, const frame_ptr_t &frame) {
+   std::lock_guard lock{m_};
+
+   if (by_key_.count(k) > 0) {
+      return;
+   }
+
+   frames_.emplace_front(k, frame);
+   by_key_.emplace(k, frames_.begin());
+
+   while (frames_.size() > max_frames_) {
+      by_key_.erase(frames_.back().first);
+      frames_.pop_back();
+   }
+}
+
+auto frame_cache::decode(const key &k) -> frame_ptr_t {
+   const auto d = decoder_for(k.video_file);
+   std::lock_guard lock{d->m};
+
+   // The frame might have been decoded by another thread, while this one was waiting for the decoder
+   if (auto frame = find(k)) {
+      return frame;
+   }
+
+   try {
+      seek(*d, k);
+      d->max_width = k.max_width;
+      d->max_height = k.max_height;
+      d->decoded.reset();
+      d->decoder->run();
+
+      if (!d->decoded) {
+         spdlog::warn("Frame {} not found in {}", k.frame_number, k.video_file);
+         return nullptr;
+      }
+
+      auto frame = std::make_shared<const frame_t>(std::move(d->decoded.value()));
+      d->decoded.reset();
+      store(k, frame);
+      return frame;
+   } catch (const std::exception &e) {
+      spdlog::error("Failed to decode frame {} of {}: {}", k.frame_number, k.video_file, e.what());
+      return nullptr;
+   }
+}
+
+auto frame_cache::decoder_for(const std::string &video_file) -> std::shared_ptr<open_decoder> {
+   std::lock_guard lock{decoders_m_};
+
+   auto it = std::find_if(std::begin(decoders_), std::end(decoders_),
+                          [&](const auto &d) { return d->video_file == video_file; });
+   if (it != std::end(decoders_)) {
+      decoders_.splice(decoders_.begin(), decoders_, it);
+      return decoders_.front();
+   }
+
+   decoders_.push_front(std::make_shared<open_decoder>());
+   decoders_.front()->video_file = video_file;
+
+   while (decoders_.size() > max_open_decoders) {
+      decoders_.pop_back();
+   }
+
+   return decoders_.front();
+}
+
+void frame_cache::seek(open_decoder &d, const key &k) {
+   using decoder_t = ffmpeg::decoder;
+
+   if (d.decoder) {
+      d.decoder->seek(k.frame_number);
+      return;
+   }
+
+   // Note: the decoder is owned by `d`, so the callback can keep the pointer
+   auto frame_cb = [dp = &d](const AVFrame &ffmpeg_frame, std::int64_t frame_number) {
+      dp->decoded.emplace();
+      dp->decoder->to_frame(ffmpeg_frame, frame_number, dp->decoded.value(), dp->max_width, dp->max_height);
+      return decoder_t::action::stop;
+   };
+
+   d.decoder = std::make_unique<decoder_t>(k.video_file, decoder_t::frame_filter::all_frames, frame_cb, k.frame_number);
+}
@@ -0,0 +1,83 @@
+/**
+ * @file   frame_ranges.cpp
+ * @author Dennis Sitelew
+ * @date   Oct. 18, 2026
+ */
+
+#include <ocs/viewer/frame_ranges.h>
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+
+namespace ocs::viewer::frame_ranges {
+
+namespace {
+
+using limits = std::numeric_limits<std::int64_t>;
+
+} // namespace
+
+frame_ranges_t merge_sorted(const frame_ranges_t &ranges) {
+   frame_ranges_t merged;
+   for (const auto &r : ranges) {
+      if (!merged.empty() && (merged.back().second == limits::max() || r.first <= merged.back().second + 1)) {
+         merged.back().second = std::max(merged.back().second, r.second);
+      } else {
+         merged.push_back(r);
+      }
+   }
+   return merged;
+}
+
+frame_ranges_t intersect(const frame_ranges_t &lhs, const frame_ranges_t &rhs) {
+   frame_ranges_t result;
+   auto l = std::begin(lhs);
+   auto r = std::begin(rhs);
+   while (l != std::end(lhs) && r != std::end(rhs)) {
+      const auto first = std::max(l->first, r->first);
+      const auto last = std::min(l->second, r->second);
+      if (first <= last) {
+         result.emplace_back(first, last);
+      }
+
+      if (l->second < r->second) {
+         ++l;
+      } else {
+         ++r;
+      }
+   }
+   return result;
+}
+
+frame_ranges_t unite(const frame_ranges_t &lhs, const frame_ranges_t &rhs) {
+   frame_ranges_t all;
+   all.reserve(lhs.size() + rhs.size());
+   std::merge(std::begin(lhs), std::end(lhs), std::begin(rhs), std::end(rhs), std::back_inserter(all));
+
+   return merge_sorted(all);
+}
+
+frame_ranges_t complement(const frame_ranges_t &ranges) {
+   frame_ranges_t result;
+   auto next = limits::min();
+   bool done = false;
+   for (const auto &r : ranges) {
+      if (r.first > next) {
+         result.emplace_back(next, r.first - 1);
+      }
+
+      if (r.second == limits::max()) {
+         done = true;
+         break;
+      }
+      next = r.second + 1;
+   }
+
+   if (!done) {
+      result.emplace_back(next, limits::max());
+   }
+   return result;
+}
+
+} // namespace ocs::viewer::frame_ranges
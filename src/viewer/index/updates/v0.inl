@@ -0,0 +1,41 @@
+//
+// Created by Dennis Sitelew on 18.10.26.
+//
+
+#ifndef OCS_VIEWER_INDEX_IDL_INCLUDE
+#error Internal use only
+#endif
+
+namespace {
+
+void update_v0(sqlite_burrito::versioned_database &db, std::error_code &ec) {
+   const auto sql = R"sql(
+BEGIN TRANSACTION;
+
+CREATE TABLE metadata(version INT);
+INSERT INTO  metadata(version) VALUES (0);
+
+CREATE TABLE files (
+   id INTEGER PRIMARY KEY AUTOINCREMENT NOT NULL,
+   "path" TEXT UNIQUE NOT NULL,
+   "size" INT NOT NULL,
+   "mtime" INT NOT NULL,
+   "change_counter" INT NOT NULL,
+   "last_text_entry_id" INT NOT NULL
+);
+
+-- Posting lists: every trigram maps to the text entries (of each file) containing it
+CREATE TABLE postings (
+   trigram INT NOT NULL,
+   file_id INT NOT NULL,
+   text_entry_id INT NOT NULL,
+
+   PRIMARY KEY(trigram, file_id, text_entry_id)
+) WITHOUT ROWID;
+
+COMMIT;
+)sql";
+   sqlite_burrito::statement::execute(db.get_connection(), sql, ec);
+}
+
+} // namespace
@@ -13,12 +13,33 @@ std::optional<options> options::parse(int argc, const char **argv) {
    options result;
 
    bool show_help{false};
+   bool no_index{false};
 
    auto cli =
        lyra::opt(result.video_dir, "video_dir")["-i"]["--video-dir"]("Video files directory").required() |
        lyra::opt(result.video_extension, "video_ext")["-v"]["--video-ext"]("Video file extension, e.g.: .mkv")
            .required() |
        lyra::opt(result.db_extension, "db_ext")["-d"]["--db-ext"]("Database file extension, e.g: .db").required() |
+       lyra::opt(result.max_open_databases, "max_open")["-c"]["--max-open-databases"](
+           "Maximal number of database files kept open between searches") |
+       lyra::opt(result.index_file, "index_file")["-x"]["--index-file"](
+           "Search index file, stored in the video files directory by default") |
+       lyra::opt(no_index)["--no-index"]("Search all database files, without using the search index") |
+       lyra::opt(result.archive_file, "archive_file")["--archive"](
+           "Search the archive database created by ocs-merge, instead of the database files") |
+       lyra::opt(result.results_export_file, "export_file")["--export-results"](
+           "Database file the results of each finished search are exported to") |
+       lyra::opt(result.query_cache_size, "cache_size")["--query-cache-size"](
+           "Maximal number of search results cached for the repeated queries, 0 to disable the cache") |
+       lyra::opt(result.frame_cache_size, "cache_size")["--frame-cache-size"](
+           "Maximal number of decoded video frames kept in memory") |
+       lyra::opt(result.preview_frames)["--preview-frames"](
+           "Fit the frames into the view, decoding them at the display resolution until zoomed into a text") |
+       lyra::opt(result.redraw_continuously)["--redraw-continuously"](
+           "Redraw the window all the time, instead of waiting for the input when nothing changes") |
+       lyra::opt(result.max_fps, "fps")["--max-fps"]("Maximal number of frames drawn per second, 0 for no limit") |
+       lyra::opt(result.watch_interval_ms, "ms")["--watch-interval"](
+           "How often (in milliseconds) the new and changed database files are searched, 0 to not watch them") |
        lyra::help(show_help);
 
    auto parse_result = cli.parse({argc, argv});
@@ -38,5 +59,27 @@ std::optional<options> options::parse(int argc, const char **argv) {
       return {};
    }
 
+   if (result.max_fps < 0) {
+      std::cerr << "Invalid maximal frame rate: " << result.max_fps << std::endl;
+      return std::nullopt;
+   }
+
+   if (result.watch_interval_ms < 0) {
+      std::cerr << "Invalid watch interval: " << result.watch_interval_ms << std::endl;
+      return std::nullopt;
+   }
+
+   if (!result.archive_file.empty() && !boost::filesystem::is_regular_file(result.archive_file)) {
+      std::cerr << "Archive file does not exist: " << result.archive_file << std::endl;
+      return std::nullopt;
+   }
+
+   // Note: the archive is a single file, there is nothing to rule out for the index
+   if (no_index || !result.archive_file.empty()) {
+      result.index_file.clear();
+   } else if (result.index_file.empty()) {
+      result.index_file = (boost::filesystem::path{result.video_dir} / ".ocs-search-index").string();
+   }
+
    return result;
 }
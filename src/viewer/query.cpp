@@ -0,0 +1,514 @@
+/**
+ * @file   query.cpp
+ * @author Dennis Sitelew
+ * @date   Oct. 18, 2026
+ */
+
+#include <ocs/viewer/query.h>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+
+using namespace ocs::viewer;
+
+namespace {
+
+using frame_ranges_t = query::frame_ranges_t;
+using limits = std::numeric_limits<std::int64_t>;
+
+using frame_ranges::complement;
+using frame_ranges::intersect;
+using frame_ranges::merge_sorted;
+using frame_ranges::unite;
+
+frame_ranges_t to_ranges(const query::entries_t &entries) {
+   frame_ranges_t result;
+   result.reserve(entries.size());
+   for (const auto &e : entries) {
+      result.emplace_back(e.frame_number, std::max(e.frame_number, e.last_frame_number));
+   }
+   std::sort(std::begin(result), std::end(result));
+
+   return merge_sorted(result);
+}
+
+//! @return the number in the text surrounded by optional spaces, or nothing if it's not a number or out of range
+std::optional<int> parse_int(std::string_view text) {
+   auto is_space = [](char c) { return std::isspace(static_cast<unsigned char>(c)) != 0; };
+   while (!text.empty() && is_space(text.front())) {
+      text.remove_prefix(1);
+   }
+   while (!text.empty() && is_space(text.back())) {
+      text.remove_suffix(1);
+   }
+
+   int result = 0;
+   const auto *end = text.data() + text.size();
+   const auto [ptr, ec] = std::from_chars(text.data(), end, result);
+   if (ec != std::errc{} || ptr != end) {
+      return std::nullopt;
+   }
+   return result;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+/// Class: query::parser
+////////////////////////////////////////////////////////////////////////////////
+class query::parser {
+public:
+   parser(const std::string &text, query &result)
+      : text_{text}
+      , result_{&result} {
+      // Nothing to do here
+   }
+
+public:
+   void parse() {
+      next_token();
+      result_->root_ = parse_or(false);
+      if (token_.type == token_type::close) {
+         throw std::invalid_argument("Unexpected ')' in the query");
+      }
+      if (token_.type != token_type::end) {
+         throw std::invalid_argument("Unexpected operator in the query");
+      }
+   }
+
+private:
+   enum class token_type { end, pattern, and_op, or_op, not_op, near_op, in_op, fuzzy_op, open, close };
+
+   struct token {
+      token_type type{token_type::end};
+      std::string value{};
+   };
+
+private:
+   std::size_t parse_or(bool negated) {
+      auto lhs = parse_and(negated);
+      while (token_.type == token_type::or_op) {
+         next_token();
+         const auto rhs = parse_and(negated);
+         lhs = add_node({node::kind::or_op, 0, lhs, rhs});
+      }
+      return lhs;
+   }
+
+   std::size_t parse_and(bool negated) {
+      auto lhs = parse_unary(negated);
+      while (true) {
+         if (token_.type == token_type::and_op) {
+            next_token();
+         } else if (token_.type != token_type::pattern && token_.type != token_type::not_op &&
+                    token_.type != token_type::fuzzy_op && token_.type != token_type::open) {
+            // Note: adjacent terms are implicitly AND-ed
+            break;
+         }
+
+         const auto rhs = parse_unary(negated);
+         lhs = add_node({node::kind::and_op, 0, lhs, rhs});
+      }
+      return lhs;
+   }
+
+   std::size_t parse_unary(bool negated) {
+      if (token_.type == token_type::not_op) {
+         next_token();
+         const auto operand = parse_unary(!negated);
+         return add_node({node::kind::not_op, 0, operand, 0});
+      }
+
+      if (token_.type == token_type::open) {
+         next_token();
+         const auto result = parse_or(negated);
+         if (token_.type != token_type::close) {
+            throw std::invalid_argument("Missing ')' in the query");
+         }
+         next_token();
+         return result;
+      }
+
+      if (token_.type == token_type::fuzzy_op) {
+         leaf l{leaf::kind::fuzzy};
+         l.max_distance = parse_limit();
+         next_token();
+
+         if (token_.type != token_type::pattern) {
+            throw std::invalid_argument("Search text expected after FUZZY");
+         }
+         if (token_.value.size() > ocs::common::fuzzy_pattern::max_length) {
+            throw std::invalid_argument("Fuzzy search text is too long");
+         }
+         if (static_cast<std::size_t>(l.max_distance) >= token_.value.size()) {
+            // Note: the text would be matching anywhere
+            throw std::invalid_argument("FUZZY/<n> has to be less than the length of the text");
+         }
+         l.term = add_term(token_.value);
+         next_token();
+
+         return add_node({node::kind::leaf, add_leaf(l, negated), 0, 0});
+      }
+
+      if (token_.type == token_type::pattern) {
+         leaf l{leaf::kind::pattern, add_term(token_.value)};
+         next_token();
+
+         if (token_.type == token_type::near_op) {
+            l.type = leaf::kind::near;
+            l.max_distance = parse_limit();
+            next_token();
+
+            if (token_.type != token_type::pattern) {
+               throw std::invalid_argument("Search pattern expected after NEAR");
+            }
+            l.other_term = add_term(token_.value);
+            next_token();
+         } else if (token_.type == token_type::in_op) {
+            l.type = leaf::kind::region;
+            l.area = parse_region();
+         }
+
+         return add_node({node::kind::leaf, add_leaf(l, negated), 0, 0});
+      }
+
+      throw std::invalid_argument("Search pattern expected");
+   }
+
+   //! Number of the NEAR/<n> and FUZZY/<n> operators
+   int parse_limit() const {
+      const auto result = parse_int(token_.value);
+      if (!result) {
+         throw std::invalid_argument("Operator limit is out of range");
+      }
+      return result.value();
+   }
+
+   ocs::common::database::region parse_region() {
+      // IN(left, top, right, bottom)
+      next_token();
+      if (token_.type != token_type::open) {
+         throw std::invalid_argument("Missing '(' after IN");
+      }
+
+      next_token();
+      if (token_.type != token_type::pattern) {
+         throw std::invalid_argument("IN expects the region as (left, top, right, bottom)");
+      }
+
+      std::array<int, 4> coordinates{};
+      std::string_view rest{token_.value};
+      for (std::size_t i = 0; i < coordinates.size(); ++i) {
+         const auto is_last = (i + 1 == coordinates.size());
+         const auto comma = is_last ? std::string_view::npos : rest.find(',');
+         if (!is_last && comma == std::string_view::npos) {
+            throw std::invalid_argument("IN expects the region as (left, top, right, bottom)");
+         }
+
+         const auto value = parse_int(rest.substr(0, comma));
+         if (!value) {
+            throw std::invalid_argument("IN expects the region as (left, top, right, bottom)");
+         }
+         coordinates[i] = value.value();
+         rest.remove_prefix(is_last ? rest.size() : comma + 1);
+      }
+
+      const ocs::common::database::region result{coordinates[0], coordinates[1], coordinates[2], coordinates[3]};
+
+      next_token();
+      if (token_.type != token_type::close) {
+         throw std::invalid_argument("Missing ')' after the region");
+      }
+      next_token();
+
+      return result;
+   }
+
+   std::size_t add_term(const std::string &value) {
+      auto &terms = result_->terms_;
+
+      const auto it = std::find(std::begin(terms), std::end(terms), value);
+      if (it != std::end(terms)) {
+         return static_cast<std::size_t>(std::distance(std::begin(terms), it));
+      }
+
+      terms.push_back(value);
+      return terms.size() - 1;
+   }
+
+   std::size_t add_leaf(const leaf &l, bool negated) {
+      result_->leaves_.push_back(l);
+      result_->is_positive_.push_back(!negated);
+      return result_->leaves_.size() - 1;
+   }
+
+   std::size_t add_node(const node &n) {
+      result_->nodes_.push_back(n);
+      return result_->nodes_.size() - 1;
+   }
+
+   void next_token() {
+      auto is_space = [](char c) { return std::isspace(static_cast<unsigned char>(c)) != 0; };
+      auto is_special = [&](char c) { return is_space(c) || c == '(' || c == ')' || c == '"'; };
+
+      while (pos_ < text_.size() && is_space(text_[pos_])) {
+         ++pos_;
+      }
+
+      token_ = {};
+      if (pos_ >= text_.size()) {
+         return;
+      }
+
+      const auto c = text_[pos_];
+      if (c == '(' || c == ')') {
+         token_.type = (c == '(') ? token_type::open : token_type::close;
+         ++pos_;
+         return;
+      }
+
+      if (c == '"') {
+         const auto end = text_.find('"', pos_ + 1);
+         if (end == std::string::npos) {
+            throw std::invalid_argument("Missing closing quote in the query");
+         }
+
+         token_ = {token_type::pattern, text_.substr(pos_ + 1, end - pos_ - 1)};
+         pos_ = end + 1;
+         return;
+      }
+
+      // A pattern spans all the words up to the next operator, so that a text without any operators is a single
+      // pattern (including its spaces)
+      const auto word_end = [&](std::size_t from) {
+         while (from < text_.size() && !is_special(text_[from])) {
+            ++from;
+         }
+         return from;
+      };
+
+      const auto keyword = [&](std::size_t from, std::size_t to) -> std::optional<token_type> {
+         const auto word = std::string_view{text_}.substr(from, to - from);
+
+         // NEAR/<pixels>, FUZZY/<edits>
+         const auto is_limited = [&](std::string_view prefix) {
+            return word.size() > prefix.size() && word.substr(0, prefix.size()) == prefix &&
+                   std::all_of(std::begin(word) + prefix.size(), std::end(word),
+                               [](char c) { return std::isdigit(static_cast<unsigned char>(c)) != 0; });
+         };
+         if (is_limited("NEAR/")) {
+            return token_type::near_op;
+         }
+         if (is_limited("FUZZY/")) {
+            return token_type::fuzzy_op;
+         }
+
+         // Note: only directly followed by the region, so that "IN" is still usable in the patterns
+         if (word == "IN" && to < text_.size() && text_[to] == '(') {
+            return token_type::in_op;
+         }
+
+         if (word == "AND") {
+            return token_type::and_op;
+         }
+         if (word == "OR") {
+            return token_type::or_op;
+         }
+         if (word == "NOT") {
+            return token_type::not_op;
+         }
+         return std::nullopt;
+      };
+
+      auto end = word_end(pos_);
+      if (const auto op = keyword(pos_, end)) {
+         token_.type = op.value();
+         if (token_.type == token_type::near_op || token_.type == token_type::fuzzy_op) {
+            const auto limit = text_.find('/', pos_) + 1;
+            token_.value = text_.substr(limit, end - limit);
+         }
+         pos_ = end;
+         return;
+      }
+
+      const auto begin = pos_;
+      while (true) {
+         auto next = end;
+         while (next < text_.size() && is_space(text_[next])) {
+            ++next;
+         }
+
+         const auto next_end = word_end(next);
+         if (next == next_end || keyword(next, next_end)) {
+            break;
+         }
+         end = next_end;
+      }
+
+      token_ = {token_type::pattern, text_.substr(begin, end - begin)};
+      pos_ = end;
+   }
+
+private:
+   const std::string &text_;
+   std::size_t pos_{0};
+   token token_{};
+
+   query *result_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// Class: query
+////////////////////////////////////////////////////////////////////////////////
+query query::parse(const std::string &text) {
+   query result;
+   result.text_ = text;
+   parser{text, result}.parse();
+   return result;
+}
+
+bool query::is_exact(std::size_t term) const {
+   return std::any_of(std::begin(leaves_), std::end(leaves_), [&](const auto &l) {
+      return l.type != leaf::kind::fuzzy && (l.term == term || (l.type == leaf::kind::near && l.other_term == term));
+   });
+}
+
+bool query::is_single_pattern() const {
+   return nodes_.size() == 1 && leaves_.front().type == leaf::kind::pattern;
+}
+
+bool query::may_match(const std::vector<bool> &term_may_match) const {
+   return nodes_.empty() || may_match(root_, term_may_match);
+}
+
+bool query::may_match(std::size_t idx, const std::vector<bool> &term_may_match) const {
+   const auto &n = nodes_[idx];
+   switch (n.type) {
+      case node::kind::leaf: {
+         // Note: the text filters are exact, those can't rule out the approximate matches
+         const auto &l = leaves_[n.leaf];
+         if (l.type == leaf::kind::fuzzy) {
+            return true;
+         }
+         return term_may_match[l.term] && (l.type != leaf::kind::near || term_may_match[l.other_term]);
+      }
+
+      case node::kind::and_op:
+         return may_match(n.lhs, term_may_match) && may_match(n.rhs, term_may_match);
+
+      case node::kind::or_op:
+         return may_match(n.lhs, term_may_match) || may_match(n.rhs, term_may_match);
+
+      case node::kind::not_op:
+         // Absence of a term is never known for sure
+         return true;
+   }
+   return true;
+}
+
+auto query::evaluate(std::size_t idx, const std::vector<frame_ranges_t> &leaf_ranges) const -> frame_ranges_t {
+   const auto &n = nodes_[idx];
+   switch (n.type) {
+      case node::kind::leaf:
+         return leaf_ranges[n.leaf];
+
+      case node::kind::and_op:
+         return intersect(evaluate(n.lhs, leaf_ranges), evaluate(n.rhs, leaf_ranges));
+
+      case node::kind::or_op:
+         return unite(evaluate(n.lhs, leaf_ranges), evaluate(n.rhs, leaf_ranges));
+
+      case node::kind::not_op:
+         return complement(evaluate(n.lhs, leaf_ranges));
+   }
+   return {};
+}
+
+void query::find(ocs::common::database &db,
+                 const leaf &l,
+                 std::int64_t min_frame,
+                 std::int64_t max_frame,
+                 entries_t &entries) const {
+   switch (l.type) {
+      case leaf::kind::pattern:
+         db.find_text_overlapping(terms_[l.term], min_frame, max_frame, entries);
+         return;
+
+      case leaf::kind::near:
+         db.find_text_near(terms_[l.term], terms_[l.other_term], l.max_distance, min_frame, max_frame, entries);
+         return;
+
+      case leaf::kind::region:
+         db.find_text_in_region(terms_[l.term], l.area, min_frame, max_frame, entries);
+         return;
+
+      case leaf::kind::fuzzy:
+         db.find_text_fuzzy(ocs::common::fuzzy_pattern{terms_[l.term], l.max_distance}, min_frame, max_frame,
+                            entries);
+         return;
+   }
+}
+
+void query::find(ocs::common::database &db, entries_t &entries) const {
+   find(db, limits::min(), limits::max(), entries);
+}
+
+void query::find(ocs::common::database &db, std::int64_t min_frame, std::int64_t max_frame, entries_t &entries) const {
+   entries.clear();
+
+   if (is_single_pattern() && min_frame == limits::min() && max_frame == limits::max()) {
+      db.find_text(terms_.front(), entries);
+      return;
+   }
+
+   // Posting lists of all the conditions, as the frame ranges those are visible in
+   std::vector<entries_t> leaf_entries(leaves_.size());
+   std::vector<frame_ranges_t> leaf_ranges(leaves_.size());
+   for (std::size_t i = 0; i < leaves_.size(); ++i) {
+      find(db, leaves_[i], min_frame, max_frame, leaf_entries[i]);
+      leaf_ranges[i] = to_ranges(leaf_entries[i]);
+   }
+
+   // Note: the negated conditions are matching outside of the range as well, those frames are not looked at
+   const auto matching = intersect(evaluate(root_, leaf_ranges), {{min_frame, max_frame}});
+   if (matching.empty()) {
+      return;
+   }
+
+   for (std::size_t i = 0; i < leaves_.size(); ++i) {
+      if (!is_positive_[i]) {
+         continue;
+      }
+
+      for (const auto &e : leaf_entries[i]) {
+         const std::int64_t first = e.frame_number;
+         const std::int64_t last = std::max(e.frame_number, e.last_frame_number);
+
+         auto it = std::lower_bound(std::begin(matching), std::end(matching), first,
+                                    [](const auto &range, auto frame) { return range.second < frame; });
+         for (; it != std::end(matching) && it->first <= last; ++it) {
+            auto &clipped = entries.emplace_back(e);
+            clipped.frame_number = static_cast<int>(std::max(first, it->first));
+            clipped.last_frame_number = static_cast<int>(std::min(last, it->second));
+         }
+      }
+   }
+
+   // The same span might be matching multiple conditions
+   auto as_tuple = [](const auto &e) {
+      return std::tie(e.frame_number, e.last_frame_number, e.left, e.top, e.right, e.bottom, e.text);
+   };
+   std::sort(std::begin(entries), std::end(entries),
+             [&](const auto &lhs, const auto &rhs) { return as_tuple(lhs) < as_tuple(rhs); });
+   entries.erase(std::unique(std::begin(entries), std::end(entries),
+                             [&](const auto &lhs, const auto &rhs) { return as_tuple(lhs) == as_tuple(rhs); }),
+                 std::end(entries));
+}
@@ -0,0 +1,235 @@
+/**
+ * @file   query_cache.cpp
+ * @author Dennis Sitelew
+ * @date   Oct. 18, 2026
+ */
+
+#include <ocs/common/trigrams.h>
+#include <ocs/viewer/query_cache.h>
+
+#include <algorithm>
+#include <iterator>
+#include <string_view>
+
+using namespace ocs::viewer;
+
+namespace {
+
+std::string fold(std::string_view text) {
+   std::string result;
+   result.reserve(text.size());
+   std::transform(std::begin(text), std::end(text), std::back_inserter(result),
+                  [](char c) { return static_cast<char>(ocs::common::fold_case(c)); });
+   return result;
+}
+
+bool is_wildcard(char c) {
+   return c == '%' || c == '_';
+}
+
+//! @return The text of a "%text%" pattern, or std::nullopt if the pattern has any other wildcards
+std::optional<std::string_view> contains_pattern_text(std::string_view pattern) {
+   if (pattern.size() < 3 || pattern.front() != '%' || pattern.back() != '%') {
+      return std::nullopt;
+   }
+
+   const auto text = pattern.substr(1, pattern.size() - 2);
+   if (std::any_of(std::begin(text), std::end(text), is_wildcard)) {
+      return std::nullopt;
+   }
+   return text;
+}
+
+//! @return true if every text matching the pattern contains `text`, i.e. one of the literal parts contains it
+bool pattern_implies(std::string_view pattern, std::string_view text) {
+   const auto folded_text = fold(text);
+
+   std::size_t part_begin = 0;
+   for (std::size_t i = 0; i <= pattern.size(); ++i) {
+      if (i == pattern.size() || is_wildcard(pattern[i])) {
+         if (fold(pattern.substr(part_begin, i - part_begin)).find(folded_text) != std::string::npos) {
+            return true;
+         }
+         part_begin = i + 1;
+      }
+   }
+   return false;
+}
+
+//! @return Position of the UTF-8 character following the one at `pos`
+std::size_t next_character(std::string_view text, std::size_t pos) {
+   ++pos;
+   while (pos < text.size() && (static_cast<unsigned char>(text[pos]) & 0xC0U) == 0x80U) {
+      ++pos;
+   }
+   return pos;
+}
+
+//! Match the text against the LIKE pattern, the same way sqlite does it (without ESCAPE)
+bool like_matches(std::string_view pattern, std::string_view text) {
+   const auto npos = std::string_view::npos;
+
+   // Note: backtracking to the last '%' only is enough, as it can absorb anything the previous ones could
+   std::size_t p = 0, t = 0;
+   std::size_t star_p = npos, star_t = 0;
+
+   while (t < text.size()) {
+      if (p < pattern.size() && pattern[p] == '%') {
+         star_p = ++p;
+         star_t = t;
+      } else if (p < pattern.size() && pattern[p] == '_') {
+         ++p;
+         t = next_character(text, t);
+      } else if (p < pattern.size() && ocs::common::fold_case(pattern[p]) == ocs::common::fold_case(text[t])) {
+         ++p;
+         ++t;
+      } else if (star_p != npos) {
+         p = star_p;
+         star_t = next_character(text, star_t);
+         t = star_t;
+      } else {
+         return false;
+      }
+   }
+
+   while (p < pattern.size() && pattern[p] == '%') {
+      ++p;
+   }
+   return p == pattern.size();
+}
+
+} // namespace
+
+query_cache::query_cache(std::size_t max_entries)
+   : max_entries_{max_entries} {
+   // Nothing to do here
+}
+
+auto query_cache::find(const query &q,
+                       const std::string &database_path,
+                       std::int64_t min_frame,
+                       const file_state &state) -> std::optional<value> {
+   std::lock_guard lock{m_};
+
+   const item_key_t key{database_path, min_frame};
+
+   if (auto it = by_text_.find(q.text()); it != by_text_.end()) {
+      touch(it->second);
+
+      const auto &items = it->second->items;
+      if (auto item = items.find(key); item != items.end() && item->second.state == state) {
+         return item->second.results;
+      }
+   }
+
+   // Note: only the single patterns, the spans of the boolean queries are clipped to the matching frames
+   if (!q.is_single_pattern()) {
+      return std::nullopt;
+   }
+
+   const auto &pattern = q.terms().front();
+   for (auto it = queries_.begin(); it != queries_.end(); ++it) {
+      if (it->text == q.text() || !it->pattern) {
+         continue;
+      }
+
+      const auto text = contains_pattern_text(it->pattern.value());
+      if (!text || !pattern_implies(pattern, text.value())) {
+         continue;
+      }
+
+      auto item = it->items.find(key);
+      if (item == it->items.end() || !(item->second.state == state)) {
+         continue;
+      }
+
+      value result{{}, item->second.results.video_info};
+      for (const auto &entry : item->second.results.entries) {
+         if (like_matches(pattern, entry.text)) {
+            result.entries.push_back(entry);
+         }
+      }
+
+      touch(it);
+      return result;
+   }
+
+   return std::nullopt;
+}
+
+auto query_cache::find_stale(const query &q, const std::string &database_path, std::int64_t min_frame)
+    -> std::optional<stale_value> {
+   std::lock_guard lock{m_};
+
+   auto it = by_text_.find(q.text());
+   if (it == by_text_.end()) {
+      return std::nullopt;
+   }
+
+   const auto &items = it->second->items;
+   auto item = items.find({database_path, min_frame});
+   if (item == items.end()) {
+      return std::nullopt;
+   }
+
+   touch(it->second);
+   return stale_value{item->second.results, item->second.high_water_mark};
+}
+
+void query_cache::store(const query &q,
+                        const std::string &database_path,
+                        std::int64_t min_frame,
+                        const file_state &state,
+                        std::int64_t high_water_mark,
+                        value results) {
+   if (cost(results) > max_entries_) {
+      return;
+   }
+
+   std::lock_guard lock{m_};
+
+   auto it = by_text_.find(q.text());
+   if (it == by_text_.end()) {
+      std::optional<std::string> pattern;
+      if (q.is_single_pattern()) {
+         pattern = q.terms().front();
+      }
+
+      queries_.push_front({q.text(), std::move(pattern)});
+      it = by_text_.emplace(q.text(), queries_.begin()).first;
+   } else {
+      touch(it->second);
+   }
+
+   auto &cached = *it->second;
+   const auto [item, inserted] = cached.items.try_emplace({database_path, min_frame});
+
+   const auto old_cost = inserted ? std::size_t{0} : cost(item->second.results);
+   cached.num_entries = cached.num_entries - old_cost + cost(results);
+   num_entries_ = num_entries_ - old_cost + cost(results);
+
+   item->second = {state, high_water_mark, std::move(results)};
+
+   evict(it->second);
+}
+
+void query_cache::touch(queries_t::iterator it) {
+   queries_.splice(queries_.begin(), queries_, it);
+}
+
+void query_cache::evict(queries_t::iterator keep) {
+   auto drop = [this](queries_t::iterator it) {
+      num_entries_ -= it->num_entries;
+      by_text_.erase(it->text);
+      queries_.erase(it);
+   };
+
+   while (num_entries_ > max_entries_ && std::prev(queries_.end()) != keep) {
+      drop(std::prev(queries_.end()));
+   }
+
+   // The query being stored doesn't fit the cache alone
+   if (num_entries_ > max_entries_) {
+      drop(keep);
+   }
+}
@@ -0,0 +1,96 @@
+/**
+ * @file   texture.cpp
+ * @author Dennis Sitelew
+ * @date   Oct. 18, 2026
+ */
+
+#include <ocs/viewer/render/texture.h>
+
+#include <cstring>
+
+using namespace ocs::viewer::render;
+
+texture::texture()
+   : use_pixel_buffers_{GLVersion.major >= 3} {
+   // Create a OpenGL texture identifier
+   glGenTextures(1, &handle_);
+   glBindTexture(GL_TEXTURE_2D, handle_);
+
+   // Setup filtering parameters for display
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+   // This is required on WebGL for non power-of-two textures
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+   if (use_pixel_buffers_) {
+      glGenBuffers(static_cast<GLsizei>(pixel_buffers_.size()), pixel_buffers_.data());
+   }
+}
+
+texture::~texture() {
+   // Note: the names never generated are zeroes, those are ignored
+   glDeleteBuffers(static_cast<GLsizei>(pixel_buffers_.size()), pixel_buffers_.data());
+   glDeleteTextures(1, &handle_);
+}
+
+void texture::update(const std::uint8_t *data, int width, int height) {
+   glBindTexture(GL_TEXTURE_2D, handle_);
+
+   // The rows of the decoded frames are not padded
+#if defined(GL_UNPACK_ROW_LENGTH) && !defined(__EMSCRIPTEN__)
+   glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+#endif
+   glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+   if (width != width_ || height != height_) {
+      allocate(width, height);
+   }
+
+   if (use_pixel_buffers_ && upload_through_pixel_buffer(data)) {
+      return;
+   }
+
+   glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width_, height_, GL_RGB, GL_UNSIGNED_BYTE, data);
+}
+
+void texture::allocate(int width, int height) {
+   width_ = width;
+   height_ = height;
+
+   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width_, height_, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+
+   if (use_pixel_buffers_) {
+      for (const auto buffer : pixel_buffers_) {
+         glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+         glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(size()), nullptr, GL_STREAM_DRAW);
+      }
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+   }
+}
+
+bool texture::upload_through_pixel_buffer(const std::uint8_t *data) {
+   glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixel_buffers_[next_pixel_buffer_]);
+   next_pixel_buffer_ = (next_pixel_buffer_ + 1) % pixel_buffers_.size();
+
+   // The old content is invalidated, so the driver doesn't have to wait until it's transferred
+   const auto flags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT;
+   auto *mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(size()), flags);
+   if (mapped == nullptr) {
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+      use_pixel_buffers_ = false;
+      return false;
+   }
+
+   std::memcpy(mapped, data, size());
+   const auto unmapped = glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+   // The pixels are read from the bound buffer, starting at the offset 0
+   if (unmapped == GL_TRUE) {
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width_, height_, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+   }
+
+   glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+   return unmapped == GL_TRUE;
+}
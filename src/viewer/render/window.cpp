@@ -11,9 +11,11 @@
 #include <glad/glad.h>
 #include <imgui.h>
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <sstream>
+#include <thread>
 
 using namespace ocs::viewer::render;
 
@@ -126,6 +128,11 @@ window::window(options opts, draw_cb_t cb)
    io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;
    io.ConfigDockingWithShift = true;
 
+   // The blinking text cursor would keep redrawing the window
+   if (options_.wait_for_events) {
+      io.ConfigInputTextCursorBlink = false;
+   }
+
    consume_errors("imgui");
 }
 
@@ -152,32 +159,31 @@ void window::set_title(const std::string &title) {
    SDL_SetWindowTitle(window_, title_.c_str());
 }
 
+void window::request_redraw() {
+   frames_to_draw_ = std::max(frames_to_draw_, 1);
+}
+
 void window::update() {
-   while (SDL_PollEvent(&event_) != 0) {
-      frontend::process_event(event_);
-      if (event_.type == SDL_QUIT) {
-         stop_ = true;
-      } else if (event_.type == SDL_KEYUP) {
-         if (event_.key.keysym.sym == SDLK_AC_BACK || event_.key.keysym.sym == SDLK_ESCAPE) {
-            stop_ = true;
-         }
-      } else if (event_.type == SDL_WINDOWEVENT) {
-         switch (event_.window.event) {
-            case (SDL_WINDOWEVENT_RESIZED):
-               SDL_GetWindowSize(window_, &options_.width, &options_.height);
-               break;
-            default:
-               break;
-         }
+   if (options_.wait_for_events && frames_to_draw_ == 0) {
+      // Nothing changes on the screen by itself, so sleep until something happens (but still redraw once in a while)
+      if (SDL_WaitEventTimeout(&event_, static_cast<int>(options_.idle_timeout.count())) != 0) {
+         handle_event();
       }
    }
 
+   while (SDL_PollEvent(&event_) != 0) {
+      handle_event();
+   }
+
    if (ImGui::GetIO().WantTextInput) {
       SDL_StartTextInput();
    } else {
       SDL_StopTextInput();
    }
 
+   // Note: decremented before drawing, so that the frame being drawn can request the next one
+   frames_to_draw_ = std::max(frames_to_draw_ - 1, 0);
+
    frontend_->new_frame();
 
    const auto &io = ImGui::GetIO();
@@ -190,6 +196,41 @@ void window::update() {
    frontend_->render();
 
    SDL_GL_SwapWindow(window_);
+
+   limit_frame_rate();
+}
+
+void window::handle_event() {
+   frontend::process_event(event_);
+   frames_to_draw_ = frames_after_event;
+
+   if (event_.type == SDL_QUIT) {
+      stop_ = true;
+   } else if (event_.type == SDL_KEYUP) {
+      if (event_.key.keysym.sym == SDLK_AC_BACK || event_.key.keysym.sym == SDLK_ESCAPE) {
+         stop_ = true;
+      }
+   } else if (event_.type == SDL_WINDOWEVENT) {
+      switch (event_.window.event) {
+         case (SDL_WINDOWEVENT_RESIZED):
+            SDL_GetWindowSize(window_, &options_.width, &options_.height);
+            break;
+         default:
+            break;
+      }
+   }
+}
+
+void window::limit_frame_rate() {
+   using namespace std::chrono;
+
+   if (options_.max_fps <= 0) {
+      return;
+   }
+
+   const auto frame_time = duration_cast<steady_clock::duration>(seconds{1}) / options_.max_fps;
+   std::this_thread::sleep_until(last_frame_ + frame_time);
+   last_frame_ = steady_clock::now();
 }
 
 void window::draw() const {
@@ -2,149 +2,331 @@
 // Created by Dennis Sitelew on 06.03.23.
 //
 
+#include <ocs/common/packed_box.h>
+#include <ocs/common/timestamp.h>
 #include <ocs/common/video.h>
 #include <ocs/viewer/results.h>
 
 #include <spdlog/spdlog.h>
 
-#include <boost/date_time/gregorian/gregorian.hpp>
-#include <boost/date_time/local_time/local_time.hpp>
-#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <numeric>
 
 // Include updates implementations. Those functions are usually very big and not that interesting, so they are
 // implemented in standalone modules
 #define OCS_VIEWER_IDL_INCLUDE
 #include "db/updates/v0.inl"
+#include "db/updates/v1.inl"
 
 // Note: should always be last
 #include "db/updates/update.inl"
 #undef OCS_VIEWER_IDL_INCLUDE
 
 using namespace ocs::viewer;
-namespace fs = boost::filesystem;
 
 using open_flags_t = sqlite_burrito::connection::open_flags;
 using flags_t = sqlite_burrito::statement::prepare_flags;
 
-results::results(bool in_memory)
-   : db_path_{in_memory ? ":memory:" : "search-results.db"}
-   , db_{in_memory ? (open_flags_t::memory | open_flags_t::default_mode) : open_flags_t::default_mode}
+////////////////////////////////////////////////////////////////////////////////
+/// Struct: results::columns
+////////////////////////////////////////////////////////////////////////////////
+void results::columns::reserve(std::size_t size) {
+   timestamps.reserve(size);
+   frames.reserve(size);
+   last_frames.reserve(size);
+   boxes.reserve(size);
+   confidences.reserve(size);
+   texts.reserve(size);
+   video_files.reserve(size);
+}
+
+void results::columns::clear() {
+   timestamps.clear();
+   frames.clear();
+   last_frames.clear();
+   boxes.clear();
+   confidences.clear();
+   texts.clear();
+   video_files.clear();
+}
+
+void results::columns::append(const columns &other, std::size_t idx, string_id_t string_offset) {
+   timestamps.push_back(other.timestamps[idx]);
+   frames.push_back(other.frames[idx]);
+   last_frames.push_back(other.last_frames[idx]);
+   boxes.push_back(other.boxes[idx]);
+   confidences.push_back(other.confidences[idx]);
+   texts.push_back(other.texts[idx] + string_offset);
+   video_files.push_back(other.video_files[idx] + string_offset);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// Struct: results::string_table
+////////////////////////////////////////////////////////////////////////////////
+auto results::string_table::intern(const std::string &value) -> string_id_t {
+   auto it = ids.find(value);
+   if (it != ids.end()) {
+      return it->second;
+   }
+
+   // Note: never reallocated, the capacity was reserved for all the strings of the run
+   const auto id = static_cast<string_id_t>(strings.size());
+   strings.push_back(value);
+   ids.emplace(strings.back(), id);
+   return id;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// Class: results
+////////////////////////////////////////////////////////////////////////////////
+results::results(std::string export_path)
+   : db_path_{std::move(export_path)}
+   , db_{open_flags_t::default_mode}
    , add_text_entry_{db_.get_connection(), flags_t::persistent}
-   , clear_{db_.get_connection(), flags_t::persistent}
-   , select_{db_.get_connection(), flags_t::persistent} {
+   , clear_{db_.get_connection(), flags_t::persistent} {
+   if (db_path_.empty()) {
+      return;
+   }
+
    db_.open(db_path_, CURRENT_DB_VERSION, &results::db_update);
    prepare_statements();
 }
 
-void results::store(const search::search_entry &result) {
+void results::store(const search::search_entry &result, std::uint64_t generation) {
    using namespace std::chrono;
 
-   ocs::common::video video{result.video_file_path, ffmpeg::decoder::frame_filter::all_frames, {nullptr}};
+   {
+      std::lock_guard lock{m_};
+      if (generation != generation_) {
+         // Results of a cancelled search
+         return;
+      }
+   }
+
+   // Databases created by older versions have no video properties stored, so the video file has to be probed
+   std::function<milliseconds(std::int64_t)> frame_number_to_milliseconds;
+   std::optional<ocs::common::video> video;
+   if (result.video_info) {
+      frame_number_to_milliseconds = [&](auto num) { return result.video_info->frame_number_to_milliseconds(num); };
+   } else {
+      try {
+         video.emplace(result.video_file_path, ffmpeg::decoder::frame_filter::all_frames, nullptr);
+      } catch (const std::exception &e) {
+         spdlog::error("Failed to store search results for file {}, {}", result.video_file_path, e.what());
+         return;
+      }
+      frame_number_to_milliseconds = [&](auto num) { return video->frame_number_to_milliseconds(num); };
+   }
+
+   const auto start_time = (result.video_info && result.video_info->start_time)
+                               ? result.video_info->start_time.value()
+                               : start_time_for_video(result.video_file_path);
+
+   // The run is built and sorted by the calling (search) thread, only appending it to the results is serialized
+   columns stored;
+   stored.reserve(result.entries.size());
 
-   const auto start_time = start_time_for_video(result.video_file_path);
+   string_table strings{result.entries.size() + 1};
+   const auto video_file = strings.intern(result.video_file_path);
 
-   auto &stmt = add_text_entry_;
+   for (const auto &entry : result.entries) {
+      const auto timestamp = start_time + frame_number_to_milliseconds(entry.frame_number);
+
+      stored.timestamps.push_back(timestamp.count());
+      stored.frames.push_back(entry.frame_number);
+      stored.last_frames.push_back(entry.last_frame_number);
+      stored.boxes.push_back(ocs::common::pack_box(entry.left, entry.top, entry.right, entry.bottom));
+      stored.confidences.push_back(entry.confidence);
+      stored.texts.push_back(strings.intern(entry.text));
+      stored.video_files.push_back(video_file);
+   }
+
+   std::vector<std::size_t> order(stored.size());
+   std::iota(std::begin(order), std::end(order), std::size_t{0});
+   std::stable_sort(std::begin(order), std::end(order), [&](std::size_t lhs, std::size_t rhs) {
+      return stored.timestamps[lhs] < stored.timestamps[rhs];
+   });
+
+   std::lock_guard lock{m_};
+   if (generation != generation_) {
+      return;
+   }
+
+   // The strings of the run are appended after the ones of the previous runs, its ids are shifted accordingly
+   const auto string_offset = static_cast<string_id_t>(strings_.size());
+   std::move(std::begin(strings.strings), std::end(strings.strings), std::back_inserter(strings_));
+
+   const auto begin = columns_.size();
+   for (const auto idx : order) {
+      columns_.append(stored, idx, string_offset);
+   }
+   runs_.push_back({begin, columns_.size()});
+}
+
+void results::clear(std::uint64_t generation) {
+   std::lock_guard lock{m_};
+
+   generation_ = generation;
+   columns_.clear();
+   runs_.clear();
+   num_taken_ = 0;
+   selection_.clear();
+   strings_.clear();
+}
+
+void results::take_new_entries(std::vector<entry> &entries) {
+   entries.clear();
+
+   std::lock_guard lock{m_};
+
+   entries.reserve(columns_.size() - num_taken_);
+   for (; num_taken_ < columns_.size(); ++num_taken_) {
+      entries.push_back(get_entry(num_taken_));
+   }
+}
+
+void results::start_selection() {
+   std::lock_guard lock{m_};
+
+   selection_generation_ = generation_;
+   start_merge(selection_);
+}
+
+results::optional_entry_t results::get_next() {
+   std::lock_guard lock{m_};
+
+   if (selection_generation_ != generation_) {
+      return {};
+   }
+
+   if (const auto row = next_row(selection_)) {
+      return get_entry(row.value());
+   }
+   return {};
+}
+
+void results::export_results(std::uint64_t generation) {
+   if (db_path_.empty()) {
+      return;
+   }
+
+   // Note: held for the whole export, so that the results of an older search can't overwrite the newer ones
+   std::lock_guard export_lock{export_m_};
+
+   std::vector<entry> entries;
+   {
+      std::lock_guard lock{m_};
+      if (generation != generation_) {
+         return;
+      }
+
+      std::vector<cursor> cursors;
+      start_merge(cursors);
+
+      entries.reserve(columns_.size());
+      while (const auto row = next_row(cursors)) {
+         entries.push_back(get_entry(row.value()));
+      }
+   }
 
    try {
       auto transaction = db_.get_connection().begin_transaction();
 
-      for (auto &entry : result.entries) {
-         const auto timestamp = start_time + video.frame_number_to_milliseconds(entry.frame_number);
-
-         auto total_seconds = duration_cast<seconds>(timestamp - start_time);
-         const auto num_hours = duration_cast<hours>(total_seconds);
-         total_seconds -= num_hours;
-         const auto num_minutes = duration_cast<minutes>(total_seconds);
+      clear_.reset();
+      clear_.execute();
 
+      auto &stmt = add_text_entry_;
+      for (const auto &entry : entries) {
          stmt.reset();
-         stmt.bind(":pts", timestamp.count());
-         stmt.bind(":pnum", entry.frame_number);
+         stmt.bind(":pts", entry.timestamp);
+         stmt.bind(":pnum", entry.frame);
+         stmt.bind(":plast", entry.last_frame);
          stmt.bind(":pleft", entry.left);
          stmt.bind(":ptop", entry.top);
          stmt.bind(":pright", entry.right);
          stmt.bind(":pbottom", entry.bottom);
          stmt.bind(":pconfidence", entry.confidence);
          stmt.bind(":ptext", entry.text);
-         stmt.bind(":pfile", result.video_file_path);
-         stmt.bind(":phour", (int)num_hours.count());
-         stmt.bind(":pminute", (int)num_minutes.count());
+         stmt.bind(":pfile", entry.video_file);
+         stmt.bind(":phour", entry.hour);
+         stmt.bind(":pminute", entry.minute);
          stmt.execute();
       }
 
       transaction.commit();
+      spdlog::debug("{} search results exported to {}", entries.size(), db_path_);
    } catch (const std::exception &e) {
-      spdlog::error("Failed to store search results for file {}, {}", result.video_file_path, e.what());
-      throw;
-   } catch (...) {
-      spdlog::error("Failed to store search results for file {}", result.video_file_path);
-      throw;
+      spdlog::error("Failed to export the search results to {}: {}", db_path_, e.what());
    }
 }
 
-void results::clear() {
-   clear_.reset();
-   clear_.execute();
+void results::start_merge(std::vector<cursor> &cursors) const {
+   cursors.clear();
+   for (const auto &r : runs_) {
+      if (r.begin != r.end) {
+         cursors.push_back({columns_.timestamps[r.begin], r.begin, r.end});
+      }
+   }
+   std::make_heap(std::begin(cursors), std::end(cursors), std::greater<>{});
 }
 
-void results::start_selection() {
-   select_.reset();
-}
+std::optional<std::size_t> results::next_row(std::vector<cursor> &cursors) const {
+   if (cursors.empty()) {
+      return std::nullopt;
+   }
 
-results::optional_entry_t results::get_next() {
-   auto &stmt = select_;
+   // The run with the smallest next timestamp is on the top of the heap
+   std::pop_heap(std::begin(cursors), std::end(cursors), std::greater<>{});
+   auto &next = cursors.back();
+   const auto row = next.row;
 
-   if (!stmt.step()) {
-      return {};
+   if (++next.row < next.end) {
+      next.timestamp = columns_.timestamps[next.row];
+      std::push_heap(std::begin(cursors), std::end(cursors), std::greater<>{});
+   } else {
+      cursors.pop_back();
    }
 
-   entry result;
-   stmt.get(0, result.timestamp);
-   stmt.get(1, result.frame);
-   stmt.get(2, result.left);
-   stmt.get(3, result.top);
-   stmt.get(4, result.right);
-   stmt.get(5, result.bottom);
-   stmt.get(6, result.confidence);
-   stmt.get(7, result.text);
-   stmt.get(8, result.video_file);
-   stmt.get(9, result.hour);
-   stmt.get(10, result.minute);
+   return row;
+}
+
+auto results::get_entry(std::size_t row) -> entry {
+   using namespace std::chrono;
 
-   return result;
+   const milliseconds timestamp{columns_.timestamps[row]};
+
+   // Time of the day (UTC), in the same way as the entry date is calculated
+   auto time_of_day = duration_cast<seconds>(timestamp % hours{24});
+   const auto num_hours = duration_cast<hours>(time_of_day);
+   time_of_day -= num_hours;
+   const auto num_minutes = duration_cast<minutes>(time_of_day);
+
+   const auto box = ocs::common::unpack_box(columns_.boxes[row]);
+
+   return {timestamp.count(),
+           columns_.frames[row],
+           columns_.last_frames[row],
+           box.left,
+           box.top,
+           box.right,
+           box.bottom,
+           columns_.confidences[row],
+           strings_[columns_.texts[row]],
+           strings_[columns_.video_files[row]],
+           static_cast<int>(num_hours.count()),
+           static_cast<int>(num_minutes.count())};
 }
 
 void results::prepare_statements() {
    add_text_entry_.prepare(
-       R"sql(INSERT INTO results("timestamp", "frame_number", "left", "top", "right", "bottom", "confidence", "ocr_text", "video_file", "hour", "minute")
-             VALUES (:pts, :pnum, :pleft, :ptop, :pright, :pbottom, :pconfidence, :ptext, :pfile, :phour, :pminute);)sql");
+       R"sql(INSERT INTO results("timestamp", "frame_number", "left", "top", "right", "bottom", "confidence", "ocr_text", "video_file", "hour", "minute", "last_frame_number")
+             VALUES (:pts, :pnum, :pleft, :ptop, :pright, :pbottom, :pconfidence, :ptext, :pfile, :phour, :pminute, :plast);)sql");
 
    clear_.prepare(R"sql(DELETE FROM results;)sql");
-
-   select_.prepare(
-       R"sql(SELECT timestamp, frame_number, "left", top, "right", bottom, confidence, ocr_text, video_file, hour, minute
-                          FROM results
-                          ORDER BY timestamp;)sql");
 }
 
 std::chrono::milliseconds results::start_time_for_video(const std::string &video_file) {
-   using namespace boost::gregorian;
-   using namespace boost::local_time;
-   using namespace boost::posix_time;
-
-   const auto base_name = fs::path(video_file).stem().string();
-
-   const auto time_format = "%Y-%m-%d %H-%M-%S";
-   auto time_input_facet = new local_time_input_facet(time_format);
-
-   std::stringstream ss(base_name);
-   ss.imbue(std::locale(ss.getloc(), time_input_facet));
-
-   local_date_time start_time{not_a_date_time};
-   ss >> start_time;
-
-   const ptime time_t_epoch(date(1970, 1, 1));
-   const time_duration diff = start_time.utc_time() - time_t_epoch;
-   const auto start_ms = diff.total_milliseconds();
-
-   return std::chrono::milliseconds{start_ms};
+   return ocs::common::timestamp::start_time_for_video(video_file).value_or(std::chrono::milliseconds{0});
 }
@@ -10,11 +10,25 @@
 #include <boost/filesystem/path.hpp>
 
 #include <algorithm>
+#include <limits>
+#include <set>
+#include <tuple>
 
 using namespace ocs::viewer;
 
 namespace fs = boost::filesystem;
 
+namespace {
+
+//! A span is identified by its text, first frame and box, the same way the database does it
+using span_key_t = std::tuple<std::string, int, int, int, int, int>;
+
+span_key_t span_key(const ocs::common::database::search_entry &entry) {
+   return {entry.text, entry.frame_number, entry.left, entry.top, entry.right, entry.bottom};
+}
+
+} // namespace
+
 ////////////////////////////////////////////////////////////////////////////////
 /// Class: search::thread
 ////////////////////////////////////////////////////////////////////////////////
@@ -29,14 +43,30 @@ search::thread::~thread() {
    thread_.join();
 }
 
-void search::thread::run(const std::string &text) {
+void search::thread::run(const query &q, std::uint64_t generation) {
    {
       std::unique_lock lock{m_};
-      search_text_ = text;
+      search_query_ = q;
+      search_generation_ = generation;
    }
    start();
 }
 
+void search::thread::interrupt() {
+   std::lock_guard lock{interrupt_m_};
+   if (current_db_) {
+      current_db_->interrupt();
+   }
+
+   if (current_archive_) {
+      current_archive_->interrupt();
+   }
+}
+
+bool search::thread::is_cancelled(std::uint64_t generation) const {
+   return should_stop_ || db_->get_generation() != generation;
+}
+
 void search::thread::start() {
    {
       std::unique_lock lock{m_};
@@ -51,6 +81,7 @@ void search::thread::stop() {
       should_stop_ = true;
    }
    cv_.notify_one();
+   interrupt();
 }
 
 void search::thread::thread_func() {
@@ -64,29 +95,192 @@ void search::thread::thread_func() {
 
       if (should_start_) {
          should_start_ = false;
+         const auto q = search_query_;
+         const auto generation = search_generation_;
          lock.unlock();
-         work_once();
+         work_once(q, generation);
       }
    }
    spdlog::trace("Exiting search thread...");
 }
 
-void search::thread::add_file(const database_file &file) {
-   std::unique_lock lock{m_};
-   files_.push_back(file);
+void search::thread::find(ocs::common::database &db,
+                          const query &q,
+                          const work_item &item,
+                          const std::optional<query_cache::stale_value> &stale) {
+   // The trigram filter rules out most of the databases without scanning the text entries
+   std::vector<bool> may_contain;
+   for (std::size_t i = 0; i < q.terms().size(); ++i) {
+      may_contain.push_back(!q.is_exact(i) || db.may_contain(q.terms()[i]));
+   }
+
+   if (!q.may_match(may_contain)) {
+      return;
+   }
+
+   if (q.is_single_pattern()) {
+      const auto &pattern = q.terms().front();
+      if (!stale) {
+         db.find_text(pattern, item.min_frame, item.max_frame, current_entries_);
+         return;
+      }
+
+      // The spans changed since the previous search are found again, those replace their older versions
+      const auto overlap = db.get_span_overlap().value_or(default_incremental_overlap);
+      const auto min_last_frame = stale->high_water_mark - overlap;
+      spdlog::trace("Searching {} from frame {}", item.database_path, min_last_frame);
+
+      db.find_text(pattern, item.min_frame, item.max_frame, min_last_frame, current_entries_);
+
+      // Note: a span ending before the overlap might still be merged into a span moved to its first frame, the merged
+      // one is found again under the same key then
+      std::set<span_key_t> found;
+      for (const auto &entry : current_entries_) {
+         found.insert(span_key(entry));
+      }
+
+      // Note: the previous search might have covered a different range, before the database was split into parts
+      for (const auto &entry : stale->results.entries) {
+         const bool in_range = entry.frame_number >= item.min_frame && entry.frame_number <= item.max_frame;
+         if (in_range && entry.last_frame_number < min_last_frame && !found.count(span_key(entry))) {
+            current_entries_.push_back(entry);
+         }
+      }
+      return;
+   }
+
+   // Note: the conditions are evaluated per frame, so each part is searched on its own frames, looking at the spans
+   // started in the previous parts as well. A span matching across the parts is split at their boundary.
+   q.find(db, item.min_frame, item.max_frame, current_entries_);
 }
 
-void search::thread::work_once() {
-   for (const auto &f : files_) {
+void search::thread::find_archived(const query &q, const work_item &item, std::uint64_t generation) {
+   std::vector<ocs::common::archive::video_entries> videos;
+
+   {
+      std::lock_guard lock{interrupt_m_};
+      current_archive_ = db_->archive_.get();
+   }
+
+   try {
+      // Note: only the single patterns are searched in the archive, the other queries are rejected upfront
+      db_->archive_->find_text(q.terms().front(), videos);
+   } catch (const std::exception &e) {
+      videos.clear();
+      if (!is_cancelled(generation)) {
+         spdlog::error("Error searching {}: {}", item.database_path, e.what());
+      }
+   }
+
+   {
+      std::lock_guard lock{interrupt_m_};
+      current_archive_ = nullptr;
+   }
+
+   for (auto &video : videos) {
+      ocs::common::database::video_info info{};
+      info.frame_rate = video.frame_rate;
+      info.start_time = video.start_time;
+
+      db_->results_->store({std::move(video.video_path), std::move(video.entries), info}, generation);
+   }
+
+   db_->decrement_remaining_size(item, current_entries_, current_video_info_, generation);
+}
+
+void search::thread::work_once(const query &q, std::uint64_t generation) {
+   bool can_skip = false;
+   while (auto item = db_->get_next_item(generation, can_skip)) {
+      // Stopping, or a new search was started in the meantime, no need to finish this one
+      if (is_cancelled(generation)) {
+         spdlog::trace("Search for '{}' cancelled", q.text());
+         return;
+      }
+
+      current_entries_.clear();
+      current_video_info_.reset();
+
+      if (db_->archive_) {
+         find_archived(q, *item, generation);
+         continue;
+      }
+
+      // The index rules the file out, unless it was changed after being indexed
+      if (can_skip && db_->is_indexed(item->database_path)) {
+         db_->decrement_remaining_size(*item, current_entries_, current_video_info_, generation);
+         continue;
+      }
+
+      std::optional<query_cache::file_state> state;
+      if (auto cached = db_->find_cached(q, *item, state)) {
+         db_->decrement_remaining_size(*item, cached->entries, cached->video_info, generation);
+         continue;
+      }
+
+      // The database was changed since it was searched, most likely it's still being written
+      std::optional<query_cache::stale_value> stale;
+      if (state && q.is_single_pattern()) {
+         stale = db_->cache_.find_stale(q, item->database_path, item->min_frame);
+      }
+
+      // Note: has to outlive the `current_db_` pointer
+      open_database db{};
+      bool failed = false;
+      std::int64_t high_water_mark = -1;
+
       try {
-         ocs::common::database db(f.database_path, true);
-         db.find_text(search_text_, current_entries_);
+         db = db_->acquire_database(item->database_path);
+
+         {
+            std::lock_guard lock{interrupt_m_};
+            current_db_ = db.db.get();
+         }
+
+         // Note: read before searching, the frames stored in the meantime are searched again by the next search
+         high_water_mark = db.db->get_starting_frame_number() - 1;
+
+         find(*db.db, q, *item, stale);
+
+         if (!current_entries_.empty()) {
+            current_video_info_ = db.db->get_video_info();
+         }
       } catch (const std::exception &e) {
-         spdlog::error("Error searching {}: {}", f.database_path, e.what());
+         failed = true;
+         if (!is_cancelled(generation)) {
+            spdlog::error("Error searching {}: {}", item->database_path, e.what());
+         }
       } catch (...) {
-         spdlog::error("Error searching {}: {}", f.database_path);
+         failed = true;
+         if (!is_cancelled(generation)) {
+            spdlog::error("Error searching {}", item->database_path);
+         }
       }
-      db_->decrement_remaining_size(f, current_entries_);
+
+      {
+         std::lock_guard lock{interrupt_m_};
+         current_db_ = nullptr;
+      }
+
+      if (failed && is_cancelled(generation)) {
+         // The query was interrupted, the connection itself is still fine
+         spdlog::trace("Search for '{}' cancelled", q.text());
+         if (db.db) {
+            db_->release_database(item->database_path, std::move(db));
+         }
+         return;
+      }
+
+      // Note: a database that failed is not returned to the pool, it's reopened by the next search
+      if (!failed) {
+         db_->release_database(item->database_path, std::move(db));
+
+         if (state) {
+            db_->cache_.store(q, item->database_path, item->min_frame, state.value(), high_water_mark,
+                              {current_entries_, current_video_info_});
+         }
+      }
+
+      db_->decrement_remaining_size(*item, current_entries_, current_video_info_, generation);
    }
 }
 
@@ -95,34 +289,113 @@ void search::thread::work_once() {
 ////////////////////////////////////////////////////////////////////////////////
 search::search(results &res, options options)
    : options_(std::move(options))
+   , cache_{options_.query_cache_size}
    , results_{&res} {
-   auto max_threads = std::thread::hardware_concurrency() - 1;
+   // Leave one core to the UI, but always have at least one search thread
+   const auto max_threads = std::max(std::thread::hardware_concurrency(), 2U) - 1;
    for (std::size_t i = 0; i < max_threads; ++i) {
       threads_.emplace_back(new thread(*this));
    }
+
+   if (!options_.archive_file.empty()) {
+      archive_ = std::make_unique<ocs::common::archive>(options_.archive_file, true);
+   }
+
+   if (!options_.index_file.empty()) {
+      try {
+         index_ = std::make_unique<search_index>(options_.index_file);
+         index_thread_ = std::thread{[this]() { index_thread_func(); }};
+      } catch (const std::exception &e) {
+         spdlog::warn("Can't open the search index {}, searching all files: {}", options_.index_file, e.what());
+      }
+   }
 }
 
 search::~search() {
+   if (index_thread_.joinable()) {
+      {
+         std::lock_guard lock{index_m_};
+         index_should_stop_ = true;
+      }
+      index_cv_.notify_one();
+      index_thread_.join();
+   }
+
    threads_.clear();
 }
 
 void search::collect_files() {
    spdlog::debug("Collecting files...");
 
-   video_files_.clear();
-   database_files_.clear();
+   auto files = list_files();
+   update_index(files.file_states);
+
+   spdlog::debug("{} video and {} database files found, {} work items", files.video_files.size(),
+                 files.database_files.size(), files.work_items.size());
+
+   std::unique_lock lock{m_};
+   use_files(std::move(files));
+}
 
-   total_size_ = 0;
+void search::update_files() {
+   auto files = list_files();
+   update_index(files.file_states);
 
-   std::vector<std::uint64_t> thread_loads{};
-   thread_loads.resize(threads_.size(), 0);
+   spdlog::trace("{} video and {} database files found, {} work items", files.video_files.size(),
+                 files.database_files.size(), files.work_items.size());
 
-   auto get_next_index = [&] {
-      using namespace std;
-      return distance(begin(thread_loads), min_element(begin(thread_loads), end(thread_loads)));
+   std::unique_lock lock{m_};
+   pending_files_ = std::move(files);
+}
+
+void search::update_index(std::vector<search_index::file_state> files) {
+   if (!index_) {
+      return;
+   }
+
+   {
+      std::lock_guard lock{index_m_};
+      pending_index_files_ = std::move(files);
+   }
+   index_cv_.notify_one();
+}
+
+void search::index_thread_func() {
+   spdlog::trace("Starting search index thread...");
+
+   auto is_stopping = [this]() {
+      std::lock_guard lock{index_m_};
+      return index_should_stop_;
    };
 
-   std::vector<thread::database_file> search_files;
+   std::unique_lock lock{index_m_};
+   while (true) {
+      index_cv_.wait(lock, [this] { return index_should_stop_ || pending_index_files_; });
+      if (index_should_stop_) {
+         break;
+      }
+
+      auto files = std::move(pending_index_files_.value());
+      pending_index_files_.reset();
+      lock.unlock();
+
+      // Note: once the index was built, it's used while being updated as well. The files changed since they were
+      // indexed are not skipped by the searches anyway.
+      try {
+         index_->update(files, is_stopping);
+         index_ready_ = true;
+      } catch (const std::exception &e) {
+         spdlog::warn("Error updating the search index: {}", e.what());
+      }
+
+      lock.lock();
+   }
+
+   spdlog::trace("Exiting search index thread...");
+}
+
+auto search::list_files() const -> file_list {
+   file_list result;
 
    // Find all database and video files
    fs::directory_iterator end_iter;
@@ -131,38 +404,208 @@ void search::collect_files() {
          const auto path = dir_itr->path();
          auto extension = path.extension();
 
-         if (extension == options_.db_extension) {
+         // Note: the database files are not searched while the archive is used
+         if (!archive_ && extension == options_.db_extension) {
+            // Note: the files might be created or removed while the directory is being listed
+            boost::system::error_code ec;
+            const auto size = fs::file_size(path, ec);
+            const auto mtime = ec ? std::time_t{} : fs::last_write_time(path, ec);
+            if (ec) {
+               spdlog::debug("Skipping database file {}: {}", path.string(), ec.message());
+               continue;
+            }
+
             auto as_string = path.string();
             spdlog::trace("Found a database file: {}", as_string);
-            database_files_.emplace_back(as_string);
+            result.database_files.emplace_back(as_string);
 
-            auto size = fs::file_size(path);
             auto video_path = path;
             video_path.replace_extension(options_.video_extension);
 
-            search_files.push_back({as_string, video_path.string(), size});
-            total_size_ += size;
+            add_work_items(as_string, video_path.string(), size, result.work_items);
+            result.total_size += size;
+
+            const auto change_counter = ocs::common::database::read_change_counter(as_string);
+            result.file_states.push_back({as_string, size, mtime, change_counter});
          }
 
          if (extension == options_.video_extension) {
             auto as_string = path.string();
             spdlog::trace("Found a video file: {}", as_string);
-            video_files_.emplace_back(std::move(as_string));
+            result.video_files.emplace_back(std::move(as_string));
+         }
+      }
+   }
+
+   if (archive_) {
+      using limits = std::numeric_limits<std::int64_t>;
+
+      // Note: the size is only used for the progress, which must not be empty
+      boost::system::error_code ec;
+      auto size = static_cast<std::uint64_t>(fs::file_size(options_.archive_file, ec));
+      if (ec || size == 0) {
+         size = 1;
+      }
+
+      // The whole archive is searched by a single query
+      result.work_items.push_back({options_.archive_file, {}, limits::min(), limits::max(), size});
+      result.total_size = size;
+   }
+
+   // Largest items first, so that the small ones are filling the gaps at the end of the search
+   std::stable_sort(std::begin(result.work_items), std::end(result.work_items),
+                    [](const auto &lhs, const auto &rhs) { return lhs.size > rhs.size; });
+
+   return result;
+}
+
+void search::use_files(file_list files) {
+   video_files_ = std::move(files.video_files);
+   database_files_ = std::move(files.database_files);
+
+   work_items_ = std::move(files.work_items);
+   total_size_ = files.total_size;
+   next_item_ = 0;
+}
+
+void search::add_work_items(const std::string &database_path,
+                            const std::string &video_path,
+                            std::uint64_t size,
+                            std::vector<work_item> &items) const {
+   using limits = std::numeric_limits<std::int64_t>;
+
+   // Databases larger than that are split into multiple items, so that a single file doesn't occupy one thread
+   // while the others are idle
+   const std::uint64_t max_item_size = 64ULL * 1024 * 1024;
+
+   // Length of a part, about half an hour of a 30 fps video
+   const std::int64_t frames_per_part = 1 << 16;
+
+   std::int64_t num_frames = 0;
+   if (size > max_item_size) {
+      try {
+         ocs::common::database db{database_path, true};
+         num_frames = db.get_starting_frame_number();
+      } catch (const std::exception &e) {
+         spdlog::warn("Can't read the frame count of {}, not splitting it: {}", database_path, e.what());
+      }
+   }
+
+   // Note: the part boundaries are fixed frame numbers, so the parts of a growing database keep their ranges (and
+   // their cached results), only the last one grows and new ones are appended
+   const auto num_parts = (num_frames + frames_per_part - 1) / frames_per_part;
+   if (num_parts <= 1) {
+      items.push_back({database_path, video_path, limits::min(), limits::max(), size});
+      return;
+   }
+
+   // Note: the spans are clustered by their first frame, so each part is a continuous range of the table. The size
+   // of a part is estimated from its share of the frames.
+   const auto size_per_part = static_cast<std::uint64_t>(static_cast<double>(size) *
+                                                         static_cast<double>(frames_per_part) /
+                                                         static_cast<double>(num_frames));
+
+   for (std::int64_t i = 0; i < num_parts; ++i) {
+      const bool is_first = i == 0;
+      const bool is_last = i == num_parts - 1;
+
+      const auto min_frame = is_first ? limits::min() : i * frames_per_part;
+      const auto max_frame = is_last ? limits::max() : (i + 1) * frames_per_part - 1;
+      const auto part_size = is_last ? size - size_per_part * static_cast<std::uint64_t>(num_parts - 1) : size_per_part;
+
+      items.push_back({database_path, video_path, min_frame, max_frame, part_size});
+   }
+}
+
+auto search::get_next_item(std::uint64_t generation, bool &can_skip) -> std::optional<work_item> {
+   std::unique_lock lock{m_};
+
+   if (generation != generation_ || next_item_ >= work_items_.size()) {
+      return std::nullopt;
+   }
+
+   const auto &item = work_items_[next_item_++];
+   std::vector<bool> may_contain;
+   for (const auto &candidates : candidates_) {
+      may_contain.push_back(!candidates || candidates->count(item.database_path));
+   }
+   can_skip = !query_.may_match(may_contain);
+   return item;
+}
+
+auto search::find_cached(const query &q, const work_item &item, std::optional<query_cache::file_state> &state)
+    -> std::optional<query_cache::value> {
+   boost::system::error_code ec;
+   const auto size = fs::file_size(item.database_path, ec);
+   const auto mtime = ec ? std::time_t{} : fs::last_write_time(item.database_path, ec);
+   if (ec) {
+      return std::nullopt;
+   }
+
+   // Note: a span extended in place doesn't change the size, and the mtime might not change within a second
+   const auto change_counter = ocs::common::database::read_change_counter(item.database_path);
+   state = query_cache::file_state{size, mtime, change_counter};
+   return cache_.find(q, item.database_path, item.min_frame, state.value());
+}
+
+bool search::is_indexed(const std::string &path) const {
+   boost::system::error_code ec;
+   const auto size = fs::file_size(path, ec);
+   const auto mtime = ec ? std::time_t{} : fs::last_write_time(path, ec);
+   if (ec) {
+      return false;
+   }
+
+   const auto change_counter = ocs::common::database::read_change_counter(path);
+   return index_->is_up_to_date({path, size, mtime, change_counter});
+}
+
+auto search::acquire_database(const std::string &path) -> open_database {
+   const auto size = static_cast<std::uint64_t>(fs::file_size(path));
+   const auto mtime = fs::last_write_time(path);
+
+   {
+      std::unique_lock lock{pool_m_};
+      auto it = idle_databases_.find(path);
+      if (it != idle_databases_.end()) {
+         auto &idle = it->second;
+         auto result = std::move(idle.back());
+         idle.pop_back();
+         --num_idle_databases_;
+
+         if (idle.empty()) {
+            idle_databases_.erase(it);
          }
+
+         if (result.size == size && result.mtime == mtime) {
+            return result;
+         }
+
+         spdlog::trace("Reopening changed database: {}", path);
       }
    }
 
-   // Sort the search files by size in order to distribute the load more evenly
-   std::sort(std::begin(search_files), std::end(search_files),
-             [](const auto &lhs, const auto &rhs) { return lhs.size < rhs.size; });
+   return {std::make_unique<ocs::common::database>(path, true), size, mtime};
+}
+
+void search::release_database(const std::string &path, open_database db) {
+   std::unique_lock lock{pool_m_};
 
-   for (const auto &entry : search_files) {
-      const auto idx = get_next_index();
-      thread_loads[idx] += entry.size;
-      threads_[idx]->add_file(entry);
+   if (num_idle_databases_ >= options_.max_open_databases) {
+      // Out of the file handles budget, the database is closed
+      return;
    }
 
-   spdlog::debug("{} video and {} database files found", video_files_.size(), database_files_.size());
+   idle_databases_[path].push_back(std::move(db));
+   ++num_idle_databases_;
+}
+
+auto search::get_thumbnail(const std::string &database_path, std::int64_t frame_number)
+    -> std::optional<ocs::common::thumbnail> {
+   auto db = acquire_database(database_path);
+   auto result = db.db->get_thumbnail(frame_number);
+   release_database(database_path, std::move(db));
+   return result;
 }
 
 void search::find_text(const std::string &text) {
@@ -171,26 +614,87 @@ void search::find_text(const std::string &text) {
       return;
    }
 
-   remaining_size_ = total_size_;
-   results_->clear();
+   std::optional<query> q;
+   try {
+      q = query::parse(text);
+   } catch (const std::invalid_argument &e) {
+      // Most likely an incomplete query, while it's being typed
+      spdlog::debug("Invalid query '{}': {}", text, e.what());
+      return;
+   }
+
+   if (archive_ && !q->is_single_pattern()) {
+      spdlog::warn("Only the text patterns can be searched in the archive, not '{}'", text);
+      return;
+   }
+
+   // Cancel the running search: the threads are checking the generation between the work items, and the queries
+   // running right now are interrupted
+   const auto generation = ++generation_;
+   for (auto &t : threads_) {
+      t->interrupt();
+   }
+
+   std::vector<std::optional<search_index::paths_t>> candidates(q->terms().size());
+   if (index_ && index_ready_) {
+      try {
+         for (std::size_t i = 0; i < candidates.size(); ++i) {
+            if (q->is_exact(i)) {
+               candidates[i] = index_->find_files(q->terms()[i]);
+            }
+         }
+      } catch (const std::exception &e) {
+         spdlog::warn("Error querying the search index, searching all files: {}", e.what());
+         std::fill(std::begin(candidates), std::end(candidates), std::nullopt);
+      }
+   }
+
+   {
+      std::unique_lock lock{m_};
+      if (pending_files_) {
+         use_files(std::move(pending_files_.value()));
+         pending_files_.reset();
+      }
+
+      remaining_size_ = total_size_;
+      next_item_ = 0;
+      query_ = q.value();
+      candidates_ = std::move(candidates);
+      results_->clear(generation);
+   }
 
    search_start_ = std::chrono::steady_clock::now();
 
    for (auto &t : threads_) {
-      t->run(text);
+      t->run(q.value(), generation);
    }
 }
 
-void search::decrement_remaining_size(const thread::database_file &file, const db_entries_t &entries) {
-   std::unique_lock lock{m_};
-
+void search::decrement_remaining_size(const work_item &item,
+                                      const db_entries_t &entries,
+                                      const video_info_t &video_info,
+                                      std::uint64_t generation) {
+   // Note: stored without holding the search lock, the results are ignoring the cancelled searches themselves
    if (!entries.empty()) {
-      results_->store({file.video_path, entries});
+      results_->store({item.video_path, entries, video_info}, generation);
    }
 
-   remaining_size_ -= file.size;
-   if (remaining_size_ == 0) {
+   {
+      std::unique_lock lock{m_};
+
+      if (generation != generation_) {
+         // Results of a cancelled search
+         return;
+      }
+
+      remaining_size_ -= item.size;
+      if (remaining_size_ != 0) {
+         return;
+      }
+
       const auto duration = std::chrono::steady_clock::now() - search_start_;
       spdlog::debug("Done in {}ms", std::chrono::duration_cast<std::chrono::milliseconds>(duration).count());
    }
+
+   results_->export_results(generation);
 }
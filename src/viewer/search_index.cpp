@@ -0,0 +1,273 @@
+/**
+ * @file   search_index.cpp
+ * @author Dennis Sitelew
+ * @date   Oct. 18, 2026
+ */
+
+#include <ocs/common/database.h>
+#include <ocs/viewer/search_index.h>
+
+#include <spdlog/spdlog.h>
+#include <sqlite3.h>
+
+#include <algorithm>
+#include <iterator>
+
+// Include updates implementations
+#define OCS_VIEWER_INDEX_IDL_INCLUDE
+#include "index/updates/v0.inl"
+
+// Note: should always be last
+#include "index/updates/update.inl"
+#undef OCS_VIEWER_INDEX_IDL_INCLUDE
+
+using namespace ocs::viewer;
+
+using open_flags_t = sqlite_burrito::connection::open_flags;
+using flags_t = sqlite_burrito::statement::prepare_flags;
+
+search_index::search_index(std::string db_path)
+   : db_path_{std::move(db_path)}
+   , db_{open_flags_t::default_mode}
+   , get_files_{db_.get_connection(), flags_t::persistent}
+   , add_file_{db_.get_connection(), flags_t::persistent}
+   , update_file_{db_.get_connection(), flags_t::persistent}
+   , remove_file_{db_.get_connection(), flags_t::persistent}
+   , remove_orphaned_postings_{db_.get_connection(), flags_t::persistent}
+   , add_posting_{db_.get_connection(), flags_t::persistent}
+   , get_postings_{db_.get_connection(), flags_t::persistent} {
+   db_.open(db_path_, CURRENT_DB_VERSION, &search_index::db_update);
+
+   // The posting lists are read on every search, let sqlite map them into the memory instead of copying the pages
+   sqlite_burrito::statement::execute(db_.get_connection(), "PRAGMA mmap_size = 1073741824;");
+
+   prepare_statements();
+}
+
+void search_index::update(const std::vector<file_state> &files, const std::function<bool()> &is_cancelled) {
+   std::unique_lock lock{database_mutex_};
+   load_files();
+   lock.unlock();
+
+   std::size_t num_indexed = 0;
+   std::size_t num_reset = 0;
+   for (const auto &file : files) {
+      // Note: the postings of the files reset so far are ignored by the lookups, those are removed by a later update
+      if (is_cancelled && is_cancelled()) {
+         spdlog::debug("Search index update cancelled: {} files indexed", num_indexed);
+         return;
+      }
+
+      // Note: the files are only changed by the update itself, so those can be looked at without locking
+      auto it = files_.find(file.path);
+      if (it != files_.end() && it->second.is_in_state(file)) {
+         continue;
+      }
+
+      spdlog::debug("Indexing {}...", file.path);
+
+      lock.lock();
+      try {
+         auto transaction = db_.get_connection().begin_transaction();
+
+         // The text entry ids are never reused, so normally only the new entries have to be indexed. A smaller file
+         // is most likely a different database though, which has to be indexed from scratch.
+         auto indexed = (it != files_.end()) ? it->second : indexed_file{0, 0, 0, 0, 0};
+         if (it == files_.end() || file.size < it->second.size) {
+            if (it != files_.end()) {
+               remove_file_.reset();
+               remove_file_.bind(":pid", it->second.id);
+               remove_file_.execute();
+               ++num_reset;
+            }
+
+            add_file_.reset();
+            add_file_.bind(":ppath", file.path);
+            add_file_.execute();
+
+            indexed = {sqlite3_last_insert_rowid(db_.get_connection().get_handle()), 0, 0, 0, 0};
+         }
+
+         index_file(file, indexed);
+         transaction.commit();
+
+         files_[file.path] = indexed;
+         ++num_indexed;
+      } catch (const std::exception &e) {
+         // The file stays not up to date, so it's always searched
+         spdlog::warn("Error indexing {}: {}", file.path, e.what());
+         load_files();
+      }
+      lock.unlock();
+   }
+
+   lock.lock();
+
+   // Forget the removed files, the postings of those (and of the re-indexed ones) are removed in one pass
+   std::unordered_set<std::string> present;
+   std::transform(std::begin(files), std::end(files), std::inserter(present, std::end(present)),
+                  [](const auto &f) { return f.path; });
+
+   std::size_t num_removed = 0;
+   for (auto it = files_.begin(); it != files_.end();) {
+      if (present.count(it->first)) {
+         ++it;
+         continue;
+      }
+
+      remove_file_.reset();
+      remove_file_.bind(":pid", it->second.id);
+      remove_file_.execute();
+
+      it = files_.erase(it);
+      ++num_removed;
+   }
+
+   // Note: appending to a file keeps its postings, a full scan of those is only needed if some were dropped
+   if (num_reset > 0 || num_removed > 0) {
+      remove_orphaned_postings_.reset();
+      remove_orphaned_postings_.execute();
+   }
+
+   spdlog::debug("Search index updated: {} files indexed, {} removed", num_indexed, num_removed);
+}
+
+void search_index::index_file(const file_state &file, indexed_file &indexed) {
+   ocs::common::database db{file.path, true};
+
+   std::vector<ocs::common::database::text_value> entries;
+   db.get_text_entries(indexed.last_text_entry_id, entries);
+
+   for (const auto &entry : entries) {
+      for (const auto trigram : ocs::common::text_trigrams(entry.value)) {
+         add_posting_.reset();
+         add_posting_.bind(":ptri", static_cast<std::int64_t>(trigram));
+         add_posting_.bind(":pfile", indexed.id);
+         add_posting_.bind(":pentry", entry.id);
+         add_posting_.execute();
+      }
+   }
+
+   if (!entries.empty()) {
+      indexed.last_text_entry_id = entries.back().id;
+   }
+   indexed.size = file.size;
+   indexed.mtime = file.mtime;
+   indexed.change_counter = file.change_counter;
+
+   update_file_.reset();
+   update_file_.bind(":pid", indexed.id);
+   update_file_.bind(":psize", static_cast<std::int64_t>(indexed.size));
+   update_file_.bind(":pmtime", static_cast<std::int64_t>(indexed.mtime));
+   update_file_.bind(":pcounter", static_cast<std::int64_t>(indexed.change_counter));
+   update_file_.bind(":plast", indexed.last_text_entry_id);
+   update_file_.execute();
+}
+
+void search_index::load_files() {
+   files_.clear();
+
+   auto &stmt = get_files_;
+   stmt.reset();
+
+   while (stmt.step()) {
+      std::string path;
+      std::int64_t id, size, mtime, change_counter, last_id;
+      stmt.get(0, id);
+      stmt.get(1, path);
+      stmt.get(2, size);
+      stmt.get(3, mtime);
+      stmt.get(4, change_counter);
+      stmt.get(5, last_id);
+
+      files_[path] = {id, static_cast<std::uint64_t>(size), static_cast<std::time_t>(mtime),
+                      static_cast<std::uint32_t>(change_counter), last_id};
+   }
+}
+
+auto search_index::find_files(const std::string &pattern) -> std::optional<paths_t> {
+   const auto trigrams = ocs::common::like_pattern_trigrams(pattern);
+   if (trigrams.empty()) {
+      return std::nullopt;
+   }
+
+   std::lock_guard lock{database_mutex_};
+
+   // Intersect the (file, text entry) posting lists, the text entry has to contain all the trigrams
+   std::vector<posting_t> matching, postings, intersection;
+   for (std::size_t i = 0; i < trigrams.size(); ++i) {
+      get_postings(trigrams[i], postings);
+
+      if (i == 0) {
+         std::swap(matching, postings);
+      } else {
+         intersection.clear();
+         std::set_intersection(std::begin(matching), std::end(matching), std::begin(postings), std::end(postings),
+                               std::back_inserter(intersection));
+         std::swap(matching, intersection);
+      }
+
+      if (matching.empty()) {
+         break;
+      }
+   }
+
+   std::unordered_set<std::int64_t> file_ids;
+   for (const auto &posting : matching) {
+      file_ids.insert(posting.first);
+   }
+
+   paths_t result;
+   for (const auto &[path, file] : files_) {
+      if (file_ids.count(file.id)) {
+         result.insert(path);
+      }
+   }
+
+   return result;
+}
+
+bool search_index::is_up_to_date(const file_state &file) const {
+   std::lock_guard lock{database_mutex_};
+
+   auto it = files_.find(file.path);
+   return it != files_.end() && it->second.is_in_state(file);
+}
+
+void search_index::get_postings(ocs::common::trigram_t trigram, std::vector<posting_t> &postings) {
+   postings.clear();
+
+   auto &stmt = get_postings_;
+   stmt.reset();
+   stmt.bind(":ptri", static_cast<std::int64_t>(trigram));
+
+   while (stmt.step()) {
+      auto &posting = postings.emplace_back();
+      stmt.get(0, posting.first);
+      stmt.get(1, posting.second);
+   }
+}
+
+void search_index::prepare_statements() {
+   get_files_.prepare(R"sql(SELECT id, path, size, mtime, change_counter, last_text_entry_id FROM files;)sql");
+
+   add_file_.prepare(
+       R"sql(INSERT INTO files(path, size, mtime, change_counter, last_text_entry_id)
+          VALUES (:ppath, 0, 0, 0, 0);)sql");
+
+   update_file_.prepare(
+       R"sql(UPDATE files SET size = :psize, mtime = :pmtime, change_counter = :pcounter, last_text_entry_id = :plast
+          WHERE id = :pid;)sql");
+
+   remove_file_.prepare(R"sql(DELETE FROM files WHERE id = :pid;)sql");
+
+   // Note: there is no index by the file, removing the postings of each file separately would be a full scan each
+   remove_orphaned_postings_.prepare(
+       R"sql(DELETE FROM postings WHERE file_id NOT IN (SELECT id FROM files);)sql");
+
+   add_posting_.prepare(
+       R"sql(INSERT OR IGNORE INTO postings(trigram, file_id, text_entry_id) VALUES (:ptri, :pfile, :pentry);)sql");
+
+   get_postings_.prepare(
+       R"sql(SELECT file_id, text_entry_id FROM postings WHERE trigram = :ptri ORDER BY file_id, text_entry_id;)sql");
+}
@@ -12,229 +12,218 @@
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <cmath>
+
 using namespace ocs::viewer::views;
 
-frame_view::frame_view(search_results_view &search_results)
-   : search_results_view_{&search_results} {
+frame_view::frame_view(search_results_view &search_results, frame_cache &frames, bool preview_frames)
+   : search_results_view_{&search_results}
+   , frame_cache_{&frames}
+   , preview_frames_{preview_frames} {
    // Nothing to do here
 }
 
 void frame_view::load_image_from_frame() {
-   const auto &frame = current_frame_.value();
+   const auto k = key_for(current_frame_.value());
 
-   using decoder_t = ffmpeg::decoder;
-   decoder_t *decoder_ptr;
-   auto frame_cb = [&decoder_ptr, this](const AVFrame &ffmpeg_frame, std::int64_t frame_number) {
-      decoder_t::frame decoded;
-      decoder_ptr->to_frame(ffmpeg_frame, frame_number, decoded);
-      make_texture(decoded);
-      return decoder_t::action::stop;
-   };
+   if (const auto decoded = frame_cache_->find(k)) {
+      show_image(*decoded, decoded->frame_width, decoded->frame_height);
+      loaded_key_ = k;
+      return;
+   }
 
-   decoder_t decoder(frame.video_file, ocs::ffmpeg::decoder::frame_filter::all_frames, frame_cb, frame.number);
-   decoder_ptr = &decoder;
-   decoder.run();
-}
+   // The thumbnail stored at ingest is shown right away, the frame replaces it once decoded in the background
+   if (const auto preview = frame_cache_->get_preview(k)) {
+      show_image(preview->image, preview->frame_width, preview->frame_height);
+      frame_cache_->request(k);
+      requested_key_ = k;
+      return;
+   }
 
-void frame_view::make_texture(const ffmpeg::decoder::frame &decoded) {
-   // Create a OpenGL texture identifier
-   GLuint image_texture;
-   glGenTextures(1, &image_texture);
-   glBindTexture(GL_TEXTURE_2D, image_texture);
-
-   // Setup filtering parameters for display
-   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-   // This is required on WebGL for non power-of-two textures
-   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-   // Upload pixels into texture
-#if defined(GL_UNPACK_ROW_LENGTH) && !defined(__EMSCRIPTEN__)
-   glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-#endif
-   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, decoded.width, decoded.height, 0, GL_RGB, GL_UNSIGNED_BYTE,
-                decoded.data.data());
-
-   texture_handle_ = image_texture;
-   texture_width_ = decoded.width;
-   texture_height_ = decoded.height;
+   if (const auto decoded = frame_cache_->get(k)) {
+      show_image(*decoded, decoded->frame_width, decoded->frame_height);
+      loaded_key_ = k;
+   }
 }
 
-void frame_view::set_current_frame(const frame_t &frame) {
-   if (texture_handle_ != 0) {
-      glDeleteTextures(1, &texture_handle_);
-      texture_handle_ = 0;
+void frame_view::update_image() {
+   if (!has_image_ || !current_frame_) {
+      return;
    }
 
-   current_frame_ = frame;
-   if (current_frame_) {
-      load_image_from_frame();
-      was_dragging_ = false;
-      scroll_to_idx_ = 0;
+   const auto k = key_for(current_frame_.value());
+   if (loaded_key_ == k) {
+      return;
+   }
 
-      const auto &f = current_frame_.value();
-      const auto &minute = *f.owner;
-      const auto &hour = *minute.owner;
-      const auto &day = *hour.owner;
+   // Note: checked before looking the frame up, so that a frame decoded in between is not missed
+   const bool is_requested = frame_cache_->is_requested(k);
+   if (const auto decoded = frame_cache_->find(k)) {
+      show_image(*decoded, decoded->frame_width, decoded->frame_height);
+      loaded_key_ = k;
+      return;
+   }
 
-      const auto new_title = fmt::format("{} {:02}:{:02} - {}", day.name, hour.number, minute.number, f.number);
-      render::window::instance().set_title(new_title);
+   if (!is_requested) {
+      if (requested_key_ == k) {
+         // Failed to decode, the lower resolution image is kept
+         return;
+      }
+
+      frame_cache_->request(k);
+      requested_key_ = k;
    }
+
+   // Keep checking, the frame is decoded in the background
+   render::window::instance().request_redraw();
 }
 
-void frame_view::scroll_to_text_entry(const search_results_view::text &entry) const {
-   const auto view_port_middle = ImVec2{view_port_size_.x / 2.0f, view_port_size_.y / 2.0f};
-   const auto entry_half_size =
-       ImVec2{static_cast<float>(entry.right - entry.left) / 2.0f, static_cast<float>(entry.top - entry.bottom) / 2.0f};
-   const auto entry_middle =
-       ImVec2{static_cast<float>(entry.left) + entry_half_size.x, static_cast<float>(entry.top) + entry_half_size.y};
+ocs::viewer::frame_cache::key frame_view::key_for(const search_results_view::frame &frame) const {
+   if (!is_fitted()) {
+      return {frame.video_file, frame.number};
+   }
 
-   ImGui::SetScrollX(entry_middle.x - view_port_middle.x);
-   ImGui::SetScrollY(entry_middle.y - view_port_middle.y);
+   // Rounded up, so that the decoded frames are still used after small changes of the view size
+   const auto round_up = [](float size) {
+      const auto pixels = static_cast<int>(std::ceil(size));
+      return (pixels + view_size_step - 1) / view_size_step * view_size_step;
+   };
+   return {frame.video_file, frame.number, round_up(view_port_size_.x), round_up(view_port_size_.y)};
 }
 
-void frame_view::jump_to_next_frame() {
-   const auto frame = &current_frame_.value();
-   const auto minute = frame->owner;
-   const auto &frames = minute->frames;
+bool frame_view::is_fitted() const {
+   return preview_frames_ && !zoomed_ && view_port_size_.x > 0.0f && view_port_size_.y > 0.0f;
+}
 
-   if (frame->owner_idx == frames.size() - 1) {
-      spdlog::info("No frames left in current minute, going to the next one");
-      jump_to_next_minute();
-      return;
+float frame_view::display_scale() const {
+   if (!is_fitted() || frame_width_ <= 0 || frame_height_ <= 0) {
+      return 1.0f;
    }
 
-   set_current_frame(frames[frame->owner_idx + 1]);
+   const auto scale_x = view_port_size_.x / static_cast<float>(frame_width_);
+   const auto scale_y = view_port_size_.y / static_cast<float>(frame_height_);
+   return std::min({scale_x, scale_y, 1.0f});
 }
 
-void frame_view::jump_to_previous_frame() {
-   const auto frame = &current_frame_.value();
-   const auto minute = frame->owner;
-   const auto &frames = minute->frames;
+int frame_view::highlight_alpha() const {
+   using namespace std::chrono;
 
-   if (frame->owner_idx == 0) {
-      spdlog::info("First frame, going to the previous minute");
-      jump_to_previous_minute();
-      return;
+   constexpr int min_alpha = 64;
+   constexpr int max_alpha = 255;
+
+   const auto elapsed = duration_cast<milliseconds>(clock_t::now() - highlight_start_);
+   if (elapsed >= highlight_duration) {
+      return max_alpha;
    }
 
-   set_current_frame(frames[frame->owner_idx - 1]);
+   render::window::instance().request_redraw();
+
+   // Fading out and back in, during every period
+   const auto half_period = highlight_period.count() / 2;
+   const auto phase = elapsed.count() % highlight_period.count();
+   const auto distance = (phase < half_period) ? phase : (highlight_period.count() - phase);
+   return max_alpha - static_cast<int>((max_alpha - min_alpha) * distance / half_period);
 }
 
-void frame_view::jump_to_next_minute() {
-   const auto minute = current_frame_.value().owner;
-   const auto hour = minute->owner;
-   const auto &minutes = hour->minutes;
+void frame_view::prefetch_neighbours() const {
+   using level = search_results_view::level;
 
-   if (minute->owner_idx == minutes.size() - 1) {
-      spdlog::info("No minutes left in current hour, going to the next one");
-      jump_to_next_hour();
+   const auto &index = current_frame_.value().index;
+   if (!index) {
       return;
    }
 
-   set_current_frame(minutes[minute->owner_idx + 1].frames[0]);
-}
+   // The most likely next jumps first
+   std::vector<frame_cache::key> keys;
+   for (const auto lvl : {level::frame, level::minute, level::hour}) {
+      for (const auto forward : {true, false}) {
+         const auto idx = search_results_view_->jump(index.value(), lvl, forward);
+         if (idx == index.value()) {
+            continue;
+         }
+
+         auto k = key_for(search_results_view_->get_frame(idx));
+         if (std::find(std::begin(keys), std::end(keys), k) == std::end(keys)) {
+            keys.push_back(std::move(k));
+         }
+      }
+   }
 
-void frame_view::jump_to_previous_minute() {
-   const auto minute = current_frame_.value().owner;
-   const auto hour = minute->owner;
-   const auto &minutes = hour->minutes;
+   frame_cache_->prefetch(std::move(keys));
+}
 
-   if (minute->owner_idx == 0) {
-      spdlog::info("First minute, going to the previous hour");
-      jump_to_previous_hour();
-      return;
+void frame_view::show_image(const ffmpeg::decoder::frame &decoded, int frame_width, int frame_height) {
+   if (!texture_) {
+      texture_ = std::make_unique<render::texture>();
    }
 
-   const auto &prev_minute = minutes[minute->owner_idx - 1];
-   set_current_frame(prev_minute.frames[prev_minute.frames.size() - 1]);
+   texture_->update(decoded.data.data(), decoded.width, decoded.height);
+   has_image_ = true;
+   frame_width_ = frame_width;
+   frame_height_ = frame_height;
 }
 
-bool frame_view::is_shift_pressed() {
-   return ImGui::IsKeyDown(ImGuiKey_ModShift);
-}
+void frame_view::set_current_frame(const frame_t &frame) {
+   has_image_ = false;
+   loaded_key_.reset();
+   requested_key_.reset();
 
-void frame_view::jump_to_next_hour() {
-   if (is_shift_pressed()) {
-      jump_to_next_day();
-      return;
-   }
+   // The whole frame is shown first in the preview mode, otherwise the view is scrolled to the first text
+   zoomed_ = false;
 
-   const auto minute = current_frame_.value().owner;
-   const auto hour = minute->owner;
-   const auto day = hour->owner;
-   const auto &hours = day->hours;
+   current_frame_ = frame;
+   if (current_frame_) {
+      load_image_from_frame();
+      prefetch_neighbours();
+      was_dragging_ = false;
+      scroll_to_idx_ = preview_frames_ ? -1 : 0;
+      highlight_start_ = clock_t::now();
 
-   if (hour->owner_idx == hours.size() - 1) {
-      spdlog::info("No hours left in current day, going to the next one");
-      jump_to_next_day();
-      return;
+      const auto &f = current_frame_.value();
+      const auto new_title = fmt::format("{} - {}", search_results_view::time_to_string(f.timestamp), f.number);
+      render::window::instance().set_title(new_title);
    }
-
-   const auto &next_hour = hours[hour->owner_idx + 1];
-   set_current_frame(next_hour.minutes[0].frames[0]);
 }
 
-void frame_view::jump_to_previous_hour() {
-   if (is_shift_pressed()) {
-      jump_to_previous_day();
+void frame_view::relink_current_frame() {
+   if (!current_frame_) {
       return;
    }
 
-   const auto minute = current_frame_.value().owner;
-   const auto hour = minute->owner;
-   const auto day = hour->owner;
-   const auto &hours = day->hours;
-
-   if (hour->owner_idx == 0) {
-      spdlog::info("First hour, going to the previous day");
-      jump_to_previous_day();
-      return;
+   auto &current = current_frame_.value();
+   const auto idx = search_results_view_->find_frame(current.timestamp, current.video_file, current.number);
+   if (idx) {
+      current = search_results_view_->get_frame(idx.value());
+   } else {
+      current.index.reset();
    }
-
-   const auto &prev_hour = hours[hour->owner_idx - 1];
-   const auto &last_minute = prev_hour.minutes[prev_hour.minutes.size() - 1];
-   set_current_frame(last_minute.frames[last_minute.frames.size() - 1]);
 }
 
-void frame_view::jump_to_next_day() {
-   const auto minute = current_frame_.value().owner;
-   const auto hour = minute->owner;
-   const auto day = hour->owner;
-   const auto &days = search_results_view_->get_days();
-
-   if (day->owner_idx == days.size() - 1) {
-      spdlog::info("No days left to go, going to the last possible frame");
-      const auto &last_day = days[days.size() - 1];
-      const auto &last_hour = last_day.hours[last_day.hours.size() - 1];
-      const auto &last_minute = last_hour.minutes[last_hour.minutes.size() - 1];
-      const auto &last_frame = last_minute.frames[last_minute.frames.size() - 1];
-      set_current_frame(last_frame);
-      return;
-   }
+void frame_view::scroll_to_text_entry(const search_results_view::text &entry) const {
+   const auto view_port_middle = ImVec2{view_port_size_.x / 2.0f, view_port_size_.y / 2.0f};
+   const auto entry_half_size =
+       ImVec2{static_cast<float>(entry.right - entry.left) / 2.0f, static_cast<float>(entry.top - entry.bottom) / 2.0f};
+   const auto entry_middle =
+       ImVec2{static_cast<float>(entry.left) + entry_half_size.x, static_cast<float>(entry.top) + entry_half_size.y};
 
-   set_current_frame(days[day->owner_idx + 1].hours[0].minutes[0].frames[0]);
+   ImGui::SetScrollX(entry_middle.x - view_port_middle.x);
+   ImGui::SetScrollY(entry_middle.y - view_port_middle.y);
 }
 
-void frame_view::jump_to_previous_day() {
-   const auto minute = current_frame_.value().owner;
-   const auto hour = minute->owner;
-   const auto day = hour->owner;
-   const auto &days = search_results_view_->get_days();
+bool frame_view::is_shift_pressed() {
+   return ImGui::IsKeyDown(ImGuiKey_ModShift);
+}
 
-   if (day->owner_idx == 0) {
-      spdlog::info("First day, going to the first possible frame");
-      set_current_frame(days[0].hours[0].minutes[0].frames[0]);
+void frame_view::jump(search_results_view::level lvl, bool forward) {
+   const auto idx = current_frame_.value().index.value();
+   const auto next = search_results_view_->jump(idx, lvl, forward);
+   if (next == idx) {
+      spdlog::info("No frames left to go");
       return;
    }
 
-   const auto &prev_day = days[day->owner_idx - 1];
-   const auto &last_hour = prev_day.hours[prev_day.hours.size() - 1];
-   const auto &last_minute = last_hour.minutes[last_hour.minutes.size() - 1];
-   const auto &last_frame = last_minute.frames[last_minute.frames.size() - 1];
-   set_current_frame(last_frame);
+   set_current_frame(search_results_view_->get_frame(next));
 }
 
 void frame_view::handle_scroll_to_text_hotkeys() {
@@ -246,23 +235,43 @@ void frame_view::handle_scroll_to_text_hotkeys() {
 
       if (ImGui::IsKeyPressed(static_cast<ImGuiKey>(i))) {
          scroll_to_idx_ = idx;
+         highlight_start_ = clock_t::now();
          break;
       }
    }
 
    if (scroll_to_idx_ == -1 && ImGui::IsKeyPressed(ImGuiKey_Space)) {
       scroll_to_idx_ = 0;
+      highlight_start_ = clock_t::now();
+   }
+
+   // The text is shown in the full resolution
+   if (scroll_to_idx_ != -1) {
+      zoomed_ = true;
+   }
+
+   // Z zooms back out, to the whole frame
+   if (preview_frames_ && zoomed_ && !ImGui::GetIO().WantTextInput && ImGui::IsKeyPressed(ImGuiKey_Z)) {
+      zoomed_ = false;
    }
 }
 
 void frame_view::handle_jump_hotkeys() {
+   if (!current_frame_ || !current_frame_->index) {
+      // Not part of the current search results
+      return;
+   }
+
+   using level = search_results_view::level;
+
    static std::map<ImGuiKey, std::function<void()>> keymap = {
-       {ImGuiKey_UpArrow, [this] { jump_to_previous_frame(); }},
-       {ImGuiKey_DownArrow, [this] { jump_to_next_frame(); }},
-       {ImGuiKey_LeftArrow, [this] { jump_to_previous_minute(); }},
-       {ImGuiKey_RightArrow, [this] { jump_to_next_minute(); }},
-       {ImGuiKey_PageUp, [this] { jump_to_previous_hour(); }},
-       {ImGuiKey_PageDown, [this] { jump_to_next_hour(); }},
+       {ImGuiKey_UpArrow, [this] { jump(level::frame, false); }},
+       {ImGuiKey_DownArrow, [this] { jump(level::frame, true); }},
+       {ImGuiKey_LeftArrow, [this] { jump(level::minute, false); }},
+       {ImGuiKey_RightArrow, [this] { jump(level::minute, true); }},
+       // Shift + PageUp/PageDown jump over the days
+       {ImGuiKey_PageUp, [this] { jump(is_shift_pressed() ? level::day : level::hour, false); }},
+       {ImGuiKey_PageDown, [this] { jump(is_shift_pressed() ? level::day : level::hour, true); }},
    };
 
    for (const auto &[key, func] : keymap) {
@@ -274,19 +283,7 @@ void frame_view::handle_jump_hotkeys() {
 }
 
 void frame_view::draw() {
-   static int alpha_factor = 255;
-   static bool decrease = true;
-   const int step = 16;
-   alpha_factor -= (decrease ? step : -step);
-   if (alpha_factor < 64) {
-      decrease = false;
-      alpha_factor = 64;
-   }
-
-   if (alpha_factor > 255) {
-      decrease = true;
-      alpha_factor = 255;
-   }
+   const int alpha_factor = highlight_alpha();
 
    util::window w{name(), ImGuiWindowFlags_HorizontalScrollbar};
 
@@ -321,18 +318,23 @@ void frame_view::draw() {
       return;
    }
 
-   if (texture_handle_ == 0u) {
+   update_image();
+
+   if (!has_image_) {
       ImGui::Text("Error loading image...");
       return;
    }
 
-   ImGui::Image(reinterpret_cast<void *>(texture_handle_),
-                ImVec2(static_cast<float>(texture_width_), static_cast<float>(texture_height_)));
+   // The frame is either fitted into the view, or shown in its full size
+   const auto scale = display_scale();
+   ImGui::Image(reinterpret_cast<void *>(texture_->handle()),
+                ImVec2(static_cast<float>(frame_width_) * scale, static_cast<float>(frame_height_) * scale));
 
    const auto &frame = current_frame_.value();
 
+   // Note: in the frame coordinates, the same as the text boxes
    auto global_mouse_pos = ImGui::GetMousePos();
-   ImVec2 local_mouse_pos{global_mouse_pos.x - p.x, global_mouse_pos.y - p.y};
+   ImVec2 local_mouse_pos{(global_mouse_pos.x - p.x) / scale, (global_mouse_pos.y - p.y) / scale};
 
    if (ImGui::IsItemHovered() && ImGui::IsMouseDragging(ImGuiMouseButton_Left)) {
       ImGui::SetMouseCursor(ImGuiMouseCursor_ResizeAll);
@@ -362,11 +364,11 @@ void frame_view::draw() {
       const auto &entry = frame.texts[i];
 
       const float line_width = 8.0f;
-      auto left = p.x + static_cast<float>(entry.left);
-      auto bottom = p.y + static_cast<float>(entry.bottom);
+      auto left = p.x + static_cast<float>(entry.left) * scale;
+      auto bottom = p.y + static_cast<float>(entry.bottom) * scale;
 
-      auto right = p.x + static_cast<float>(entry.right);
-      auto top = p.y + static_cast<float>(entry.top);
+      auto right = p.x + static_cast<float>(entry.right) * scale;
+      auto top = p.y + static_cast<float>(entry.top) * scale;
 
       left -= line_width / 2.0f;
       top -= line_width / 2.0f;
@@ -384,7 +386,8 @@ void frame_view::draw() {
 
       draw_list->AddRect(ImVec2(left, top), ImVec2(right, bottom), color, 0.1, 0, line_width);
 
-      if (!scrolled && scroll_to_idx_ == i) {
+      // Note: only scrolled once the frame is shown in its full size, the scroll range is not known before
+      if (!scrolled && scroll_to_idx_ == i && scale == 1.0f) {
          scroll_to_text_entry(entry);
          scroll_to_idx_ = -1;
          scrolled = true;
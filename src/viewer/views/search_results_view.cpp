@@ -2,200 +2,413 @@
 // Created by Dennis Sitelew on 22.01.23.
 //
 
+#include <ocs/common/timestamp.h>
 #include <ocs/viewer/results.h>
 #include <ocs/viewer/views/frame_view.h>
 #include <ocs/viewer/views/search_results_view.h>
 
-#include <boost/date_time/gregorian/gregorian.hpp>
-#include <boost/date_time/local_time/local_time.hpp>
-#include <boost/date_time/posix_time/posix_time.hpp>
-
 #include <imgui.h>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
 #include <cinttypes>
+#include <iterator>
+#include <tuple>
 
 using namespace ocs::viewer::views;
 
+namespace {
+
+//! Frames are ordered by their timestamps, frames with the same timestamp are coming from different video files
+//! @note The video files are compared by their interned ids
+template <typename Entry>
+bool frame_less(const Entry &lhs, const Entry &rhs) {
+   return std::tie(lhs.timestamp, lhs.video_file, lhs.frame) < std::tie(rhs.timestamp, rhs.video_file, rhs.frame);
+}
+
+template <typename Entry>
+bool same_frame(const Entry &lhs, const Entry &rhs) {
+   return lhs.timestamp == rhs.timestamp && lhs.frame == rhs.frame && lhs.video_file == rhs.video_file;
+}
+
+//! Calendar position of the timestamp (UTC), the day is counted from the UNIX epoch
+struct time_position {
+   std::int64_t day;
+   std::int64_t hour;
+   std::int64_t minute;
+};
+
+time_position time_position_from_timestamp(std::int64_t timestamp) {
+   const std::int64_t ms_per_day = 24 * 60 * 60 * 1000;
+
+   // Note: rounding down for the timestamps before the epoch
+   auto days = timestamp / ms_per_day;
+   if (timestamp % ms_per_day < 0) {
+      --days;
+   }
+
+   const auto ms_of_day = timestamp - days * ms_per_day;
+   return {days, ms_of_day / (60 * 60 * 1000), (ms_of_day / (60 * 1000)) % 60};
+}
+
+std::string date_to_string(std::int64_t days) {
+   const auto date = ocs::common::timestamp::civil_from_days(days);
+   return fmt::format("{:04}-{:02}-{:02}", date.year, date.month, date.day);
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+/// Struct: search_results_view::tree_level
+////////////////////////////////////////////////////////////////////////////////
+void search_results_view::tree_level::truncate(std::size_t size) {
+   numbers.resize(std::min(numbers.size(), size));
+   parents.resize(std::min(parents.size(), size));
+   first_child.resize(std::min(first_child.size(), size));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// Class: search_results_view
+////////////////////////////////////////////////////////////////////////////////
 search_results_view::search_results_view(search &srch, frame_view &frame_view)
    : search_{&srch}
    , frame_view_{&frame_view} {
    // Nothing to do here
 }
 
-void search_results_view::sort_results() {
-   spdlog::debug("Sorting results...");
-   days_.clear();
+void search_results_view::merge_new_results() {
+   bool changed = false;
+
+   const auto generation = search_->get_generation();
+   if (generation != generation_) {
+      // A new search was started
+      generation_ = generation;
+      entries_.clear();
+      pending_entries_.clear();
+      strings_.clear();
+      string_ids_.clear();
+      build_tree(0);
+      changed = true;
+   }
+
+   // Note: checked before taking the entries, all the results of a finished search are taken then
+   const bool finished = search_->is_finished();
+
+   search_->get_results().take_new_entries(new_entries_);
+   for (const auto &e : new_entries_) {
+      pending_entries_.push_back({e.timestamp, e.frame, e.last_frame, e.left, e.top, e.right, e.bottom, e.confidence,
+                                  intern(e.text), intern(e.video_file)});
+   }
+
+   // Each merge rebuilds the tree after the first new frame, so the batches are coalesced while the search is running
+   const auto now = clock_t::now();
+   if (!pending_entries_.empty() && (finished || now - last_merge_ >= merge_interval)) {
+      last_merge_ = now;
+
+      // Note: stable, so that the texts of a frame are kept in the order those were found
+      std::stable_sort(std::begin(pending_entries_), std::end(pending_entries_), frame_less<entry>);
 
-   day *current_day = nullptr;
-   hour *current_hour = nullptr;
-   minute *current_minute = nullptr;
-   frame *current_frame = nullptr;
+      // Only the entries starting with the first frame of the new ones are merged, and their part of the tree rebuilt
+      const auto first = std::lower_bound(std::begin(entries_), std::end(entries_), pending_entries_.front(),
+                                          frame_less<entry>);
+      const auto first_entry = static_cast<std::size_t>(std::distance(std::begin(entries_), first));
 
-   results &res = search_->get_results();
-   res.start_selection();
+      const auto num_old = static_cast<std::ptrdiff_t>(entries_.size());
+      std::move(std::begin(pending_entries_), std::end(pending_entries_), std::back_inserter(entries_));
+      pending_entries_.clear();
 
-   auto date_time_from_video_file_start = [](const auto ts) {
-      using namespace boost::gregorian;
-      using namespace boost::local_time;
-      using namespace boost::posix_time;
+      const auto begin = std::begin(entries_);
+      std::inplace_merge(begin + static_cast<std::ptrdiff_t>(first_entry), begin + num_old, std::end(entries_),
+                         frame_less<entry>);
+
+      build_tree(first_entry);
+      changed = true;
+   }
 
-      const ptime time_t_epoch(date(1970, 1, 1));
-      const auto as_posix = time_t_epoch + boost::posix_time::milliseconds(ts.count());
-      return as_posix;
-   };
+   if (changed) {
+      rows_changed_ = true;
+      frame_view_->relink_current_frame();
+   }
+}
 
-   auto date_to_string = [](auto date) {
-      using namespace boost::gregorian;
-      using namespace boost::local_time;
-      using namespace boost::posix_time;
+auto search_results_view::intern(const std::string &value) -> string_id_t {
+   auto it = string_ids_.find(value);
+   if (it != string_ids_.end()) {
+      return it->second;
+   }
 
-      const auto date_format = "%Y-%m-%d";
-      auto time_output_facet = new time_facet(date_format);
+   const auto id = static_cast<string_id_t>(strings_.size());
+   strings_.push_back(value);
+   string_ids_.emplace(value, id);
+   return id;
+}
 
-      std::stringstream ss;
-      ss.imbue(std::locale(ss.getloc(), time_output_facet));
+void search_results_view::build_tree(std::size_t first_entry) {
+   auto &days = tree_[static_cast<std::size_t>(level::day)];
+   auto &hours = tree_[static_cast<std::size_t>(level::hour)];
+   auto &minutes = tree_[static_cast<std::size_t>(level::minute)];
+   auto &frames = tree_[frame_level];
+
+   // The frames starting before the first entry are kept, together with their parents. The last parents might be
+   // continued by the following frames.
+   const auto frames_begin = std::begin(frames.first_child);
+   const auto frames_end = frames_begin + static_cast<std::ptrdiff_t>(num_frames());
+   const auto num_kept =
+       static_cast<std::size_t>(std::distance(frames_begin, std::lower_bound(frames_begin, frames_end, first_entry)));
+
+   frames.truncate(num_kept);
+   minutes.truncate(frames.parents.empty() ? 0 : frames.parents.back() + 1);
+   hours.truncate(minutes.parents.empty() ? 0 : minutes.parents.back() + 1);
+   days.truncate(hours.parents.empty() ? 0 : hours.parents.back() + 1);
+
+   // A new node is started on every level below the first one changed
+   for (auto i = first_entry; i < entries_.size(); ++i) {
+      const auto &entry = entries_[i];
+      if (i > 0 && same_frame(entries_[i - 1], entry)) {
+         continue;
+      }
 
-      ss << date;
-      return ss.str();
-   };
+      const auto pos = time_position_from_timestamp(entry.timestamp);
 
-   auto update_frame_text = [&](auto &frame) {
-      if (frame) {
-         // Add number of entries as part of the text
-         frame->name = fmt::format("{} - {}", frame->name, frame->texts.size());
+      bool new_node = days.numbers.empty() || days.numbers.back() != pos.day;
+      if (new_node) {
+         days.numbers.push_back(pos.day);
+         days.parents.push_back(0);
+         days.first_child.push_back(hours.numbers.size());
       }
-   };
-
-   // NOTE: We cannot set the owners immediately, because the pointers may be invalidated once we add more siblings to
-   // the parent
-
-   using namespace std::chrono;
-   results::optional_entry_t opt_entry = res.get_next();
-   while (opt_entry) {
-      const auto &entry = opt_entry.value();
-      const auto file_start = results::start_time_for_video(entry.video_file);
-      const auto entry_date_time = date_time_from_video_file_start(file_start);
-      const auto entry_date = entry_date_time.date();
-      const auto day_number = entry_date.julian_day();
-      const auto frame_number = entry.frame;
-
-      if (!current_day || current_day->number != day_number) {
-         days_.push_back({});
-         current_day = &days_.back();
-         current_day->name = date_to_string(entry_date);
-         current_day->number = day_number;
-         current_day->owner_idx = days_.size() - 1;
-         current_hour = nullptr;
+
+      new_node = new_node || hours.numbers.back() != pos.hour;
+      if (new_node) {
+         hours.numbers.push_back(pos.hour);
+         hours.parents.push_back(days.numbers.size() - 1);
+         hours.first_child.push_back(minutes.numbers.size());
       }
 
-      if (!current_hour || current_hour->number != entry.hour) {
-         current_day->hours.push_back({});
-         current_hour = &current_day->hours.back();
-         current_hour->number = entry.hour;
-         current_hour->name = fmt::format("{:02}:??", entry.hour);
-         current_hour->owner_idx = current_day->hours.size() - 1;
-         current_minute = nullptr;
+      new_node = new_node || minutes.numbers.back() != pos.minute;
+      if (new_node) {
+         minutes.numbers.push_back(pos.minute);
+         minutes.parents.push_back(hours.numbers.size() - 1);
+         minutes.first_child.push_back(frames.numbers.size());
       }
 
-      if (!current_minute || current_minute->number != entry.minute) {
-         current_hour->minutes.push_back({});
-         current_minute = &current_hour->minutes.back();
-         current_minute->number = entry.minute;
-         current_minute->name = fmt::format("{:02}", entry.minute);
-         current_minute->owner_idx = current_hour->minutes.size() - 1;
+      frames.numbers.push_back(entry.frame);
+      frames.parents.push_back(minutes.numbers.size() - 1);
+      frames.first_child.push_back(i);
+   }
+
+   // Sentinels, closing the children range of the last node
+   days.first_child.push_back(hours.numbers.size());
+   hours.first_child.push_back(minutes.numbers.size());
+   minutes.first_child.push_back(frames.numbers.size());
+   frames.first_child.push_back(entries_.size());
+}
+
+auto search_results_view::get_frame(std::size_t idx) const -> frame {
+   const auto &frames = tree_[frame_level];
+   const auto begin = frames.first_child[idx];
+   const auto end = frames.first_child[idx + 1];
+
+   const auto &first = entries_[begin];
+   frame result{first.frame, first.last_frame, first.timestamp, strings_[first.video_file], {}, idx};
+
+   // All the spans, starting at the same frame are grouped together, the frame is visible as long as any of them is
+   result.texts.reserve(end - begin);
+   for (auto i = begin; i < end; ++i) {
+      const auto &entry = entries_[i];
+      result.last_number = std::max(result.last_number, entry.last_frame);
+      result.texts.push_back(
+          {entry.left, entry.top, entry.right, entry.bottom, entry.confidence, strings_[entry.text]});
+   }
+
+   return result;
+}
+
+std::optional<std::size_t> search_results_view::find_frame(std::int64_t timestamp,
+                                                           const std::string &video_file,
+                                                           std::int64_t number) const {
+   // Note: a video file without any results was never interned
+   const auto video_file_id = string_ids_.find(video_file);
+   if (video_file_id == string_ids_.end()) {
+      return std::nullopt;
+   }
 
-         update_frame_text(current_frame);
-         current_frame = nullptr;
+   const auto &frames = tree_[frame_level];
+   const auto key = std::tie(timestamp, video_file_id->second, number);
+
+   // Binary search over the first entries of the frames
+   std::size_t first = 0;
+   std::size_t count = num_frames();
+   while (count > 0) {
+      const auto step = count / 2;
+      const auto &entry = entries_[frames.first_child[first + step]];
+      if (std::tie(entry.timestamp, entry.video_file, entry.frame) < key) {
+         first += step + 1;
+         count -= step + 1;
+      } else {
+         count = step;
       }
+   }
+
+   if (first == num_frames()) {
+      return std::nullopt;
+   }
+
+   const auto &entry = entries_[frames.first_child[first]];
+   if (entry.timestamp != timestamp || entry.video_file != video_file_id->second || entry.frame != number) {
+      return std::nullopt;
+   }
+   return first;
+}
+
+std::size_t search_results_view::jump(std::size_t idx, level lvl, bool forward) const {
+   const auto target_level = static_cast<std::size_t>(lvl);
 
-      if (!current_frame || current_frame->number != frame_number) {
-         update_frame_text(current_frame);
+   auto node = idx;
+   for (auto l = frame_level; l > target_level; --l) {
+      node = tree_[l].parents[node];
+   }
+
+   const auto num_nodes = tree_[target_level].numbers.size();
+   if (forward && node + 1 >= num_nodes) {
+      return num_frames() - 1;
+   }
+   if (!forward && node == 0) {
+      return 0;
+   }
 
-         current_minute->frames.push_back({});
-         current_frame = &current_minute->frames.back();
-         current_frame->number = frame_number;
-         current_frame->name = std::to_string(frame_number);
-         current_frame->timestamp = entry.timestamp;
-         current_frame->video_file = entry.video_file;
-         current_frame->owner_idx = current_minute->frames.size() - 1;
+   // First frame of the next node, or the frame right before the first frame of the current one
+   if (forward) {
+      node = node + 1;
+      for (auto l = target_level; l < frame_level; ++l) {
+         node = tree_[l].first_child[node];
       }
+      return node;
+   }
+
+   for (auto l = target_level; l < frame_level; ++l) {
+      node = tree_[l].first_child[node];
+   }
+   return node - 1;
+}
+
+std::string search_results_view::time_to_string(std::int64_t timestamp) {
+   const auto pos = time_position_from_timestamp(timestamp);
+   return fmt::format("{} {:02}:{:02}", date_to_string(pos.day), pos.hour, pos.minute);
+}
+
+std::int64_t search_results_view::node_key(level lvl, std::size_t idx) const {
+   const auto &tree_level = tree_[static_cast<std::size_t>(lvl)];
+   switch (lvl) {
+      case level::hour:
+         return node_key(level::day, tree_level.parents[idx]) * 24 + tree_level.numbers[idx];
+
+      case level::minute:
+         return node_key(level::hour, tree_level.parents[idx]) * 60 + tree_level.numbers[idx];
+
+      default:
+         return tree_level.numbers[idx];
+   }
+}
 
-      text text_entry;
-      text_entry.left = entry.left;
-      text_entry.top = entry.top;
-      text_entry.right = entry.right;
-      text_entry.bottom = entry.bottom;
-      text_entry.confidence = entry.confidence;
-      text_entry.value = entry.text;
-      text_entry.owner = current_frame;
-      text_entry.owner_idx = current_frame->texts.size();
+bool search_results_view::is_open(level lvl, std::size_t idx) const {
+   return open_nodes_[static_cast<std::size_t>(lvl)].count(node_key(lvl, idx)) > 0;
+}
+
+void search_results_view::update_rows() {
+   rows_.clear();
+   add_rows(level::day, 0, tree_[static_cast<std::size_t>(level::day)].numbers.size());
+   rows_changed_ = false;
+}
 
-      current_frame->texts.emplace_back(std::move(text_entry));
+void search_results_view::add_rows(level lvl, std::size_t first, std::size_t last) {
+   const auto &tree_level = tree_[static_cast<std::size_t>(lvl)];
+   const auto child_level = static_cast<level>(static_cast<std::size_t>(lvl) + 1);
 
-      opt_entry = res.get_next();
+   for (auto i = first; i < last; ++i) {
+      rows_.push_back({lvl, i});
+      if (lvl != level::frame && is_open(lvl, i)) {
+         add_rows(child_level, tree_level.first_child[i], tree_level.first_child[i + 1]);
+      }
    }
+}
+
+void search_results_view::draw_row(const row &r) {
+   const auto lvl_idx = static_cast<std::size_t>(r.lvl);
+   const auto number = tree_[lvl_idx].numbers[r.idx];
+
+   ImGui::PushID(static_cast<int>(lvl_idx));
+   ImGui::PushID(static_cast<int>(r.idx));
+   ImGui::SetCursorPosX(ImGui::GetCursorPosX() + static_cast<float>(lvl_idx) * ImGui::GetStyle().IndentSpacing);
+
+   if (r.lvl == level::frame) {
+      const auto &frames = tree_[frame_level];
+      const auto &first = entries_[frames.first_child[r.idx]];
+      const auto num_texts = frames.first_child[r.idx + 1] - frames.first_child[r.idx];
 
-   // Reassign the owners
-   for (auto &day : days_) {
-      for (auto &hour : day.hours) {
-         hour.owner = &day;
+      // Note: the labels are only formatted for the visible rows, and the frame is only copied for the active one
+      const bool clicked = ImGui::Button(fmt::format("{} - {}", number, num_texts).c_str());
+      const bool hovered = ImGui::IsItemHovered();
 
-         for (auto &minute : hour.minutes) {
-            minute.owner = &hour;
+      if (clicked || hovered) {
+         const auto f = get_frame(r.idx);
+         if (clicked) {
+            frame_view_->set_current_frame(f);
+         }
 
-            for (auto &frame : minute.frames) {
-               frame.owner = &minute;
-            }
+         if (hovered) {
+            ImGui::SetTooltip("%s (%" PRIi64 "), frames %" PRIi64 " - %" PRIi64,
+                              time_to_string(first.timestamp).c_str(), first.timestamp, first.frame, f.last_number);
          }
       }
-   }
+   } else {
+      std::string label;
+      if (r.lvl == level::day) {
+         label = date_to_string(number);
+      } else if (r.lvl == level::hour) {
+         label = fmt::format("{:02}:??", number);
+      } else {
+         label = fmt::format("{:02}", number);
+      }
 
-   // Handle last frame entry
-   update_frame_text(current_frame);
+      const auto was_open = is_open(r.lvl, r.idx);
+      ImGui::SetNextItemOpen(was_open);
+
+      const auto flags = ImGuiTreeNodeFlags_NoTreePushOnOpen | ImGuiTreeNodeFlags_FramePadding;
+      if (ImGui::TreeNodeEx(label.c_str(), flags) != was_open) {
+         auto &open_nodes = open_nodes_[lvl_idx];
+         const auto key = node_key(r.lvl, r.idx);
+         if (was_open) {
+            open_nodes.erase(key);
+         } else {
+            open_nodes.insert(key);
+         }
+         rows_changed_ = true;
+      }
+   }
 
-   spdlog::debug("Results sorted!");
+   ImGui::PopID();
+   ImGui::PopID();
 }
 
 void search_results_view::draw() {
    ImGui::Begin(name());
 
-   const bool is_finished = search_->is_finished();
-   if (is_finished && !is_finished_) {
-      // Finished after starting a search on some other frame
-      is_finished_ = true;
-      sort_results();
-   } else if (!is_finished && is_finished_) {
-      // Started a new search
-      is_finished_ = false;
-   }
-
-   for (const auto &day : days_) {
-      if (ImGui::TreeNode(day.name.c_str())) {
-         for (const auto &hour : day.hours) {
-            if (ImGui::TreeNode(hour.name.c_str())) {
-               for (const auto &minute : hour.minutes) {
-                  if (ImGui::TreeNode(minute.name.c_str())) {
-                     for (const auto &frame : minute.frames) {
-                        if (ImGui::Button(frame.name.c_str())) {
-                           frame_view_->set_current_frame(frame);
-                        }
-
-                        if (ImGui::IsItemHovered()) {
-                           ImGui::SetTooltip("%s %.02d:%02d (%" PRIi64 ")", day.name.c_str(),
-                                             static_cast<int>(hour.number), static_cast<int>(minute.number),
-                                             frame.timestamp);
-                        }
-                     }
-                     ImGui::TreePop();
-                  }
-               }
-               ImGui::TreePop();
-            }
-         }
-         ImGui::TreePop();
+   // Results are added as soon as a file is searched, without waiting for the whole search to finish
+   merge_new_results();
+
+   if (rows_changed_) {
+      update_rows();
+   }
+
+   // Only the visible rows are drawn, whatever the number of results
+   ImGuiListClipper clipper;
+   clipper.Begin(static_cast<int>(rows_.size()));
+   while (clipper.Step()) {
+      for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+         draw_row(rows_[static_cast<std::size_t>(i)]);
       }
    }
+   clipper.End();
 
    ImGui::End();
 }
@@ -3,6 +3,7 @@
 //
 
 #include <ocs/viewer/render/imgui/std_input_text.h>
+#include <ocs/viewer/render/window.h>
 #include <ocs/viewer/views/search_view.h>
 
 #include <imgui.h>
@@ -10,32 +11,56 @@
 using namespace ocs::viewer::views;
 using namespace ocr::viewer::render;
 
+void search_view::start_search(bool explicit_request) {
+   last_edit_.reset();
+
+   // Note: an explicit request repeats the search of the same text, e.g. to find the results of the new files
+   const bool text_changed = last_search_text_ != search_text_;
+   if (text_change_cb_ && (explicit_request || text_changed)) {
+      text_change_cb_(search_text_);
+      last_search_text_ = search_text_;
+   }
+}
+
 void search_view::draw() {
    ImGui::Begin(name());
 
-   imgui::std_input_text("##search", search_text_);
+   const bool text_changed = imgui::std_input_text("##search", search_text_);
+   if (text_changed) {
+      last_edit_ = clock_t::now();
+   }
 
    const bool search_focused = ImGui::IsItemFocused();
    const bool enter_pressed = ImGui::IsKeyPressed(ImGuiKey_Enter);
    const bool keypad_enter_pressed = ImGui::IsKeyPressed(ImGuiKey_KeypadEnter);
 
-   bool fire_callback = search_focused && (enter_pressed || keypad_enter_pressed);
+   bool explicit_request = search_focused && (enter_pressed || keypad_enter_pressed);
 
-   if (db_->is_finished()) {
-      const bool button_pressed = ImGui::Button("Search");
-      fire_callback = button_pressed || fire_callback;
+   // A new search is cancelling the running one, so there is no need to wait for it to finish
+   const bool button_pressed = ImGui::Button("Search");
+   explicit_request = button_pressed || explicit_request;
 
-      if (fire_callback && text_change_cb_ && last_search_text_ != search_text_) {
-         text_change_cb_(search_text_);
-         last_search_text_ = search_text_;
+   bool debounce_elapsed = false;
+   if (search_as_you_type_ && last_edit_) {
+      if ((clock_t::now() - *last_edit_) >= typing_debounce) {
+         debounce_elapsed = true;
+      } else {
+         // Keep drawing until the debounce time is over
+         render::window::instance().request_redraw();
       }
-   } else {
-      ImGui::BeginDisabled();
-      ImGui::Button("Searching");
-      ImGui::EndDisabled();
+   }
+
+   if (explicit_request || debounce_elapsed) {
+      start_search(explicit_request);
+   }
+
+   ImGui::SameLine();
+   ImGui::Checkbox("As you type", &search_as_you_type_);
+
+   if (!db_->is_finished()) {
       ImGui::SameLine();
       ImGui::Text("%05.2f%%", db_->get_progress());
    }
 
    ImGui::End();
-}
\ No newline at end of file
+}
@@ -2,10 +2,13 @@
 // Created by Dennis Sitelew on 22.01.23.
 //
 
+#include <ocs/common/database.h>
 #include <ocs/viewer/views/viewer.h>
 
+#include <boost/filesystem.hpp>
 #include <imgui_internal.h>
 #include <dejavu.h>
+#include <spdlog/spdlog.h>
 
 using namespace ocs::viewer::views;
 using namespace ocs::viewer::render;
@@ -13,15 +16,28 @@ using namespace ocs::viewer::render;
 viewer::viewer(options opts)
    : opts_{std::move(opts)}
    , db_{search_results_, opts_}
-   , frame_view_{search_results_view_}
-   , search_results_{opts_.in_memory_results}
+   , frame_cache_{opts_.frame_cache_size, [this](const frame_cache::key &k) { return load_thumbnail(k); }}
+   , frame_view_{search_results_view_, frame_cache_, opts_.preview_frames}
+   , search_results_{opts_.results_export_file}
    , search_results_view_{db_, frame_view_} {
    window::options win_opts = {};
    win_opts.title = "OCS Viewer";
+   win_opts.wait_for_events = !opts_.redraw_continuously;
+   win_opts.max_fps = opts_.max_fps;
    window_ = std::make_unique<window>(win_opts, [this]() { draw(); });
 
    db_.collect_files();
 
+   if (opts_.watch_interval_ms > 0) {
+      auto files_changed = [this]() {
+         db_.update_files();
+         files_changed_ = true;
+      };
+
+      const std::chrono::milliseconds interval{opts_.watch_interval_ms};
+      watcher_ = std::make_unique<directory_watcher>(opts_.video_dir, opts_.db_extension, interval, files_changed);
+   }
+
    search_view_.set_text_change_cb([this](const std::string &text) { search_text_changed(text); });
    search_view_.set_search_engine(db_);
 
@@ -81,9 +97,39 @@ void viewer::draw() {
    search_view_.draw();
    search_results_view_.draw();
    frame_view_.draw();
+
+   // The progress and the results keep changing until the search is finished
+   if (!db_.is_finished()) {
+      window_->request_redraw();
+   }
+
+   // Note: the search isn't restarted while it's running, otherwise the files written all the time would never let it
+   // finish. Only the parts of the files changed since are searched again, the rest of the results are cached.
+   if (db_.is_finished() && files_changed_.exchange(false) && !search_text_.empty()) {
+      spdlog::trace("Files changed, searching for '{}' again", search_text_);
+      db_.find_text(search_text_);
+   }
+}
+
+std::optional<ocs::common::thumbnail> viewer::load_thumbnail(const frame_cache::key &k) {
+   auto db_path = boost::filesystem::path{k.video_file};
+   db_path.replace_extension(opts_.db_extension);
+
+   boost::system::error_code ec;
+   if (!boost::filesystem::exists(db_path, ec)) {
+      return std::nullopt;
+   }
+
+   try {
+      return db_.get_thumbnail(db_path.string(), k.frame_number);
+   } catch (const std::exception &e) {
+      spdlog::warn("Failed to read the thumbnail of frame {} from {}: {}", k.frame_number, db_path.string(), e.what());
+      return std::nullopt;
+   }
 }
 
 void viewer::search_text_changed(const std::string &text) {
+   search_text_ = text;
    db_.find_text(text);
 
    // TODO React to enter press
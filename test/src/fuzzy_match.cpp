@@ -0,0 +1,48 @@
+//
+// Created by Dennis Sitelew on 18.10.26.
+//
+
+#include <ocs/common/fuzzy_match.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+
+using namespace ocs::common;
+
+TEST_CASE("Fuzzy match - edit distance", "[fuzzy_match]") {
+   const fuzzy_pattern pattern{"invoice", 1};
+
+   REQUIRE(pattern.distance("invoice") == 0);
+   REQUIRE(pattern.distance("Total: INVOICE #42") == 0);
+   REQUIRE(pattern.distance("invice") == 1);
+   REQUIRE(pattern.distance("invoicee") == 0);
+   REQUIRE(pattern.distance("inwoice") == 1);
+   REQUIRE(pattern.distance("in voice") == 1);
+   REQUIRE(pattern.distance("nvoce") == 2);
+   REQUIRE(pattern.distance("") == 7);
+
+   REQUIRE(pattern.matches("invice"));
+   REQUIRE_FALSE(pattern.matches("nvoce"));
+   REQUIRE_FALSE(pattern.matches("receipt"));
+}
+
+TEST_CASE("Fuzzy match - OCR confusions are free", "[fuzzy_match]") {
+   const fuzzy_pattern pattern{"Hello World", 0};
+
+   REQUIRE(pattern.matches("HE1L0 W0RLD"));
+   REQUIRE(pattern.matches("he|lo wor1d"));
+   REQUIRE_FALSE(pattern.matches("Hallo World"));
+
+   REQUIRE(fuzzy_pattern{"S8Z", 0}.matches("5b2"));
+}
+
+TEST_CASE("Fuzzy match - pattern length", "[fuzzy_match]") {
+   const std::string longest(fuzzy_pattern::max_length, 'a');
+   const fuzzy_pattern pattern{longest, 2};
+   REQUIRE(pattern.matches("x" + longest.substr(1) + "y"));
+   REQUIRE(pattern.distance(longest.substr(3)) == 3);
+
+   REQUIRE_THROWS_AS(fuzzy_pattern("", 1), std::invalid_argument);
+   REQUIRE_THROWS_AS(fuzzy_pattern(longest + "a", 1), std::invalid_argument);
+}
@@ -0,0 +1,46 @@
+//
+// Created by Dennis Sitelew on 18.10.26.
+//
+
+#include <ocs/common/packed_box.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace ocs::common;
+
+TEST_CASE("Packed box - round trip", "[packed_box]") {
+   const auto box = unpack_box(pack_box(1920, 1080, 3840, 2160));
+   REQUIRE(box.left == 1920);
+   REQUIRE(box.top == 1080);
+   REQUIRE(box.right == 3840);
+   REQUIRE(box.bottom == 2160);
+}
+
+TEST_CASE("Packed box - out of range coordinates are clamped", "[packed_box]") {
+   const auto box = unpack_box(pack_box(-1, 70000, 0, 65535));
+   REQUIRE(box.left == 0);
+   REQUIRE(box.top == 65535);
+   REQUIRE(box.right == 0);
+   REQUIRE(box.bottom == 65535);
+}
+
+TEST_CASE("Packed box - matches the SQL packing", "[packed_box]") {
+   // Same as (65535 << 48) | (2 << 32) | (3 << 16) | 4 in SQLite
+   const auto packed = pack_box(65535, 2, 3, 4);
+   REQUIRE(packed == -281466386579452);
+   REQUIRE(packed < 0);
+
+   const auto box = unpack_box(packed);
+   REQUIRE(box.left == 65535);
+   REQUIRE(box.top == 2);
+   REQUIRE(box.right == 3);
+   REQUIRE(box.bottom == 4);
+}
+
+TEST_CASE("Packed box - confidence quantization", "[packed_box]") {
+   REQUIRE(quantize_confidence(87.4F) == 87);
+   REQUIRE(quantize_confidence(87.5F) == 88);
+   REQUIRE(quantize_confidence(-3.0F) == 0);
+   REQUIRE(quantize_confidence(120.0F) == 100);
+   REQUIRE(dequantize_confidence(quantize_confidence(42.0F)) == 42.0F);
+}
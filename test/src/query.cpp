@@ -0,0 +1,274 @@
+//
+// Created by Dennis Sitelew on 18.10.26.
+//
+
+#include <ocs/viewer/frame_ranges.h>
+#include <ocs/viewer/query.h>
+
+#include <boost/filesystem.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace ocs::viewer;
+
+namespace {
+
+using limits = std::numeric_limits<std::int64_t>;
+
+//! OCR database in a temporary file, removed at the end of the test
+class temp_database {
+public:
+   temp_database()
+      : path_{boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("ocs-query-%%%%-%%%%.db")} {
+      db_.emplace(path_.string());
+   }
+
+   ~temp_database() {
+      db_.reset();
+
+      boost::system::error_code ec;
+      boost::filesystem::remove(path_, ec);
+   }
+
+public:
+   //! Store the text at the box on all the frames in the [first, last] range
+   void add(const std::string &text, std::int64_t first, std::int64_t last, int left, int top) {
+      for (auto frame = first; frame <= last; ++frame) {
+         texts_.push_back({frame, {left, top, left + 10, top + 10, 90.0F, text}});
+      }
+   }
+
+   //! Store all the added texts, in the order of the frames
+   ocs::common::database &get() {
+      std::sort(std::begin(texts_), std::end(texts_),
+                [](const auto &lhs, const auto &rhs) { return lhs.first < rhs.first; });
+
+      for (std::size_t i = 0; i < texts_.size();) {
+         ocs::common::ocr_result result{};
+         result.frame_number = texts_[i].first;
+         for (; i < texts_.size() && texts_[i].first == result.frame_number; ++i) {
+            result.entries.push_back(texts_[i].second);
+         }
+         db_->store(result);
+      }
+
+      texts_.clear();
+      return db_.value();
+   }
+
+private:
+   boost::filesystem::path path_;
+   std::optional<ocs::common::database> db_{};
+   std::vector<std::pair<std::int64_t, ocs::common::text_entry>> texts_{};
+};
+
+//! (text, first frame, last frame) of the found spans, sorted
+std::vector<std::tuple<std::string, std::int64_t, std::int64_t>> find(ocs::common::database &db,
+                                                                      const std::string &text,
+                                                                      std::int64_t min_frame = limits::min(),
+                                                                      std::int64_t max_frame = limits::max()) {
+   query::entries_t entries;
+   query::parse(text).find(db, min_frame, max_frame, entries);
+
+   std::vector<std::tuple<std::string, std::int64_t, std::int64_t>> result;
+   for (const auto &e : entries) {
+      result.emplace_back(e.text, e.frame_number, e.last_frame_number);
+   }
+   std::sort(std::begin(result), std::end(result));
+   return result;
+}
+
+} // namespace
+
+TEST_CASE("Frame ranges - merging", "[query]") {
+   using frame_ranges::merge_sorted;
+
+   REQUIRE(merge_sorted({}).empty());
+   REQUIRE(merge_sorted({{1, 5}, {3, 4}, {6, 8}, {10, 12}}) == frame_ranges_t{{1, 8}, {10, 12}});
+   REQUIRE(merge_sorted({{1, limits::max()}, {5, 6}}) == frame_ranges_t{{1, limits::max()}});
+   REQUIRE(merge_sorted({{limits::min(), 0}, {1, 1}}) == frame_ranges_t{{limits::min(), 1}});
+}
+
+TEST_CASE("Frame ranges - intersection", "[query]") {
+   using frame_ranges::intersect;
+
+   REQUIRE(intersect({{1, 5}}, {}).empty());
+   REQUIRE(intersect({{1, 5}}, {{6, 8}}).empty());
+   REQUIRE(intersect({{1, 5}}, {{5, 8}}) == frame_ranges_t{{5, 5}});
+   REQUIRE(intersect({{1, 10}}, {{2, 3}, {5, 6}}) == frame_ranges_t{{2, 3}, {5, 6}});
+   REQUIRE(intersect({{1, 4}, {6, 9}}, {{3, 7}}) == frame_ranges_t{{3, 4}, {6, 7}});
+   REQUIRE(intersect({{limits::min(), limits::max()}}, {{3, 7}}) == frame_ranges_t{{3, 7}});
+}
+
+TEST_CASE("Frame ranges - union", "[query]") {
+   using frame_ranges::unite;
+
+   REQUIRE(unite({}, {}).empty());
+   REQUIRE(unite({{1, 2}}, {}) == frame_ranges_t{{1, 2}});
+   REQUIRE(unite({{1, 2}, {8, 9}}, {{3, 4}}) == frame_ranges_t{{1, 4}, {8, 9}});
+   REQUIRE(unite({{1, 5}}, {{2, 3}}) == frame_ranges_t{{1, 5}});
+   REQUIRE(unite({{1, 2}}, {{5, limits::max()}}) == frame_ranges_t{{1, 2}, {5, limits::max()}});
+}
+
+TEST_CASE("Frame ranges - complement", "[query]") {
+   using frame_ranges::complement;
+
+   REQUIRE(complement({}) == frame_ranges_t{{limits::min(), limits::max()}});
+   REQUIRE(complement({{limits::min(), limits::max()}}).empty());
+   REQUIRE(complement({{3, 5}}) == frame_ranges_t{{limits::min(), 2}, {6, limits::max()}});
+   REQUIRE(complement({{limits::min(), 5}, {7, 7}}) == frame_ranges_t{{6, 6}, {8, limits::max()}});
+   REQUIRE(complement({{1, 2}, {5, limits::max()}}) == frame_ranges_t{{limits::min(), 0}, {3, 4}});
+   REQUIRE(complement(complement({{1, 2}, {4, 9}})) == frame_ranges_t{{1, 2}, {4, 9}});
+}
+
+TEST_CASE("Query - parsing", "[query]") {
+   SECTION("A text without operators is a single pattern") {
+      const auto q = query::parse("%hello world%");
+      REQUIRE(q.is_single_pattern());
+      REQUIRE(q.terms() == std::vector<std::string>{"%hello world%"});
+   }
+
+   SECTION("AND binds tighter than OR") {
+      // a OR (b AND c)
+      const auto q = query::parse("a OR b AND c");
+      REQUIRE(q.terms() == std::vector<std::string>{"a", "b", "c"});
+      REQUIRE(q.may_match({true, false, false}));
+      REQUIRE_FALSE(q.may_match({false, true, false}));
+      REQUIRE(q.may_match({false, true, true}));
+   }
+
+   SECTION("Parentheses") {
+      // (a OR b) AND c
+      const auto q = query::parse("(a OR b) AND c");
+      REQUIRE_FALSE(q.may_match({true, false, false}));
+      REQUIRE(q.may_match({false, true, true}));
+   }
+
+   SECTION("Adjacent quoted patterns are AND-ed") {
+      const auto q = query::parse(R"("a b" "OR")");
+      REQUIRE(q.terms() == std::vector<std::string>{"a b", "OR"});
+      REQUIRE_FALSE(q.may_match({true, false}));
+      REQUIRE(q.may_match({true, true}));
+   }
+
+   SECTION("Absence of a negated term is never known") {
+      const auto q = query::parse("a AND NOT b");
+      REQUIRE(q.may_match({true, false}));
+      REQUIRE(q.may_match({true, true}));
+      REQUIRE_FALSE(q.may_match({false, true}));
+   }
+
+   SECTION("NEAR needs both terms") {
+      const auto q = query::parse("a NEAR/50 b");
+      REQUIRE_FALSE(q.is_single_pattern());
+      REQUIRE(q.terms() == std::vector<std::string>{"a", "b"});
+      REQUIRE_FALSE(q.may_match({true, false}));
+      REQUIRE(q.may_match({true, true}));
+   }
+
+   SECTION("Fuzzy terms are not filtered") {
+      const auto q = query::parse("FUZZY/1 hello AND hel% AND FUZZY/1 world AND world");
+      REQUIRE(q.terms() == std::vector<std::string>{"hello", "hel%", "world"});
+      REQUIRE_FALSE(q.is_exact(0));
+      REQUIRE(q.is_exact(1));
+      REQUIRE(q.is_exact(2));
+      REQUIRE(q.may_match({false, true, true}));
+   }
+
+   SECTION("Malformed queries") {
+      REQUIRE_THROWS_AS(query::parse("a AND"), std::invalid_argument);
+      REQUIRE_THROWS_AS(query::parse("(a OR b"), std::invalid_argument);
+      REQUIRE_THROWS_AS(query::parse("a OR b)"), std::invalid_argument);
+      REQUIRE_THROWS_AS(query::parse("\"a"), std::invalid_argument);
+      REQUIRE_THROWS_AS(query::parse("a NEAR/50"), std::invalid_argument);
+      REQUIRE_THROWS_AS(query::parse("a NEAR/99999999999999999999 b"), std::invalid_argument);
+      REQUIRE_THROWS_AS(query::parse("a IN(1,2,3)"), std::invalid_argument);
+      REQUIRE_THROWS_AS(query::parse("FUZZY/3 abc"), std::invalid_argument);
+      REQUIRE_NOTHROW(query::parse("FUZZY/2 abc"));
+      REQUIRE_THROWS_AS(query::parse("a IN(1,2,3,4,5)"), std::invalid_argument);
+      REQUIRE_THROWS_AS(query::parse("a IN(1,2,3,4x)"), std::invalid_argument);
+      REQUIRE_THROWS_AS(query::parse("a IN(1,2,3,99999999999)"), std::invalid_argument);
+      REQUIRE_NOTHROW(query::parse("a IN( 1, 2 ,3 , 4 )"));
+   }
+}
+
+TEST_CASE("Query - evaluation", "[query]") {
+   temp_database temp;
+   // Note: the frame numbers start at 1
+   temp.add("alpha", 1, 9, 0, 0);
+   temp.add("beta", 5, 14, 100, 0);
+   temp.add("gamma", 7, 8, 15, 0);
+   auto &db = temp.get();
+
+   SECTION("AND is evaluated per frame, the spans are clipped to the matching frames") {
+      using result_t = decltype(find(db, ""));
+      REQUIRE(find(db, "alpha AND beta") == result_t{{"alpha", 5, 9}, {"beta", 5, 9}});
+   }
+
+   SECTION("OR") {
+      using result_t = decltype(find(db, ""));
+      REQUIRE(find(db, "alpha OR gamma") == result_t{{"alpha", 1, 9}, {"gamma", 7, 8}});
+   }
+
+   SECTION("NOT only returns the spans of the positive conditions") {
+      using result_t = decltype(find(db, ""));
+      REQUIRE(find(db, "alpha AND NOT beta") == result_t{{"alpha", 1, 4}});
+      REQUIRE(find(db, "beta AND NOT (alpha OR gamma)") == result_t{{"beta", 10, 14}});
+      REQUIRE(find(db, "NOT alpha").empty());
+   }
+
+   SECTION("NEAR/n") {
+      using result_t = decltype(find(db, ""));
+
+      // alpha (0..10) and gamma (15..25) are 5 pixels apart, beta (100..110) is far from both
+      REQUIRE(find(db, "alpha NEAR/5 gamma") == result_t{{"alpha", 7, 8}, {"gamma", 7, 8}});
+      REQUIRE(find(db, "alpha NEAR/4 gamma").empty());
+      REQUIRE(find(db, "alpha NEAR/50 beta").empty());
+   }
+
+   SECTION("FUZZY/n") {
+      using result_t = decltype(find(db, ""));
+      REQUIRE(find(db, "FUZZY/1 a1phq") == result_t{{"alpha", 1, 9}});
+      REQUIRE(find(db, "FUZZY/1 a1phq", 5, 6) == result_t{{"alpha", 5, 6}});
+      REQUIRE(find(db, "FUZZY/1 bqtq").empty());
+   }
+
+   SECTION("IN(left, top, right, bottom)") {
+      using result_t = decltype(find(db, ""));
+      REQUIRE(find(db, "alpha IN(5, 5, 50, 50)") == result_t{{"alpha", 1, 9}});
+      REQUIRE(find(db, "alpha IN(50, 0, 60, 10)").empty());
+   }
+
+   SECTION("Searching the frame ranges separately finds the same frames") {
+      for (const auto *text : {"alpha AND beta", "alpha AND NOT beta", "beta OR gamma", "alpha NEAR/5 gamma"}) {
+         const auto whole = find(db, text);
+
+         auto parts = find(db, text, limits::min(), 6);
+         const auto rest = find(db, text, 7, limits::max());
+         parts.insert(std::end(parts), std::begin(rest), std::end(rest));
+
+         // Note: the spans crossing the boundary are split there
+         std::vector<std::tuple<std::string, std::int64_t>> whole_frames, parts_frames;
+         for (const auto &[value, first, last] : whole) {
+            for (auto frame = first; frame <= last; ++frame) {
+               whole_frames.emplace_back(value, frame);
+            }
+         }
+         for (const auto &[value, first, last] : parts) {
+            REQUIRE((last <= 6 || first >= 7));
+            for (auto frame = first; frame <= last; ++frame) {
+               parts_frames.emplace_back(value, frame);
+            }
+         }
+         std::sort(std::begin(parts_frames), std::end(parts_frames));
+
+         REQUIRE(parts_frames == whole_frames);
+      }
+   }
+}
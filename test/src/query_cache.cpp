@@ -0,0 +1,70 @@
+//
+// Created by Dennis Sitelew on 18.10.26.
+//
+
+#include <ocs/viewer/query_cache.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace ocs::viewer;
+
+namespace {
+
+query_cache::value make_results(std::initializer_list<const char *> texts) {
+   query_cache::value result{};
+   for (const auto *text : texts) {
+      auto &entry = result.entries.emplace_back();
+      entry.frame_number = 1;
+      entry.last_frame_number = 2;
+      entry.text = text;
+   }
+   return result;
+}
+
+} // namespace
+
+TEST_CASE("Query cache - exact query", "[query_cache]") {
+   query_cache cache{100};
+   const query_cache::file_state state{10, 20, 1};
+
+   const auto q = query::parse("%hello%");
+   cache.store(q, "a.db", 0, state, 5, make_results({"hello world"}));
+
+   REQUIRE(cache.find(q, "a.db", 0, state).has_value());
+   REQUIRE_FALSE(cache.find(q, "a.db", 1, state).has_value());
+   REQUIRE_FALSE(cache.find(q, "b.db", 0, state).has_value());
+
+   // The file changed since, only usable as the stale results
+   REQUIRE_FALSE(cache.find(q, "a.db", 0, {11, 20, 2}).has_value());
+
+   // Changed in place, within the same second
+   REQUIRE_FALSE(cache.find(q, "a.db", 0, {10, 20, 2}).has_value());
+   const auto stale = cache.find_stale(q, "a.db", 0);
+   REQUIRE(stale.has_value());
+   REQUIRE(stale->high_water_mark == 5);
+}
+
+TEST_CASE("Query cache - refining a single pattern", "[query_cache]") {
+   query_cache cache{100};
+   const query_cache::file_state state{10, 20, 1};
+
+   cache.store(query::parse("%hello%"), "a.db", 0, state, 5, make_results({"hello world", "hello there"}));
+
+   const auto refined = cache.find(query::parse("%hello w%"), "a.db", 0, state);
+   REQUIRE(refined.has_value());
+   REQUIRE(refined->entries.size() == 1);
+   REQUIRE(refined->entries.front().text == "hello world");
+
+   // Not implied by the cached pattern
+   REQUIRE_FALSE(cache.find(query::parse("%hell%"), "a.db", 0, state).has_value());
+}
+
+TEST_CASE("Query cache - boolean queries are never refined", "[query_cache]") {
+   query_cache cache{100};
+   const query_cache::file_state state{10, 20, 1};
+
+   // Note: the text looks like a "%text%" pattern, but these are two patterns, clipped to the frames showing both
+   cache.store(query::parse("%hello AND world%"), "a.db", 0, state, 5, make_results({"hello"}));
+
+   REQUIRE_FALSE(cache.find(query::parse(R"("%hello AND world%")"), "a.db", 0, state).has_value());
+}
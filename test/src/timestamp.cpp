@@ -0,0 +1,43 @@
+//
+// Created by Dennis Sitelew on 18.10.26.
+//
+
+#include <ocs/common/timestamp.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <tuple>
+
+using namespace ocs::common::timestamp;
+
+namespace {
+
+//! (year, month, day) of the day `days` since the UNIX epoch
+std::tuple<int, unsigned, unsigned> date_of(std::int64_t days) {
+   const auto date = civil_from_days(days);
+   return {date.year, date.month, date.day};
+}
+
+} // namespace
+
+TEST_CASE("Timestamp - civil date from days", "[timestamp]") {
+   REQUIRE(date_of(0) == std::make_tuple(1970, 1U, 1U));
+   REQUIRE(date_of(-1) == std::make_tuple(1969, 12U, 31U));
+
+   // 2000 is a leap year, 2100 is not
+   REQUIRE(date_of(11016) == std::make_tuple(2000, 2U, 29U));
+   REQUIRE(date_of(11017) == std::make_tuple(2000, 3U, 1U));
+   REQUIRE(date_of(47540) == std::make_tuple(2100, 2U, 28U));
+   REQUIRE(date_of(47541) == std::make_tuple(2100, 3U, 1U));
+}
+
+TEST_CASE("Timestamp - days from civil date", "[timestamp]") {
+   REQUIRE(days_from_civil(1970, 1, 1) == 0);
+   REQUIRE(days_from_civil(2000, 2, 29) == 11016);
+   REQUIRE(days_from_civil(2100, 3, 1) == 47541);
+
+   for (std::int64_t days = -800'000; days <= 800'000; days += 97) {
+      const auto date = civil_from_days(days);
+      REQUIRE(days_from_civil(date.year, date.month, date.day) == days);
+   }
+}
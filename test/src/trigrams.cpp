@@ -0,0 +1,49 @@
+//
+// Created by Dennis Sitelew on 18.10.26.
+//
+
+#include <ocs/common/trigram_filter.h>
+#include <ocs/common/trigrams.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace ocs::common;
+
+TEST_CASE("Trigrams - text", "[trigrams]") {
+   const auto trigrams = text_trigrams("abcab");
+   REQUIRE(trigrams.size() == 3);
+   REQUIRE(trigrams ==
+           std::vector{make_trigram('a', 'b', 'c'), make_trigram('b', 'c', 'a'), make_trigram('c', 'a', 'b')});
+
+   REQUIRE(text_trigrams("ab").empty());
+}
+
+TEST_CASE("Trigrams - ASCII case is folded", "[trigrams]") {
+   REQUIRE(text_trigrams("HeLLo") == text_trigrams("hello"));
+   REQUIRE(text_trigrams("\xD0\x9F\xD0\xB8") != text_trigrams("\xD0\xBF\xD0\xB8"));
+}
+
+TEST_CASE("Trigrams - LIKE pattern", "[trigrams]") {
+   // Only the literal parts of the pattern are used
+   REQUIRE(like_pattern_trigrams("%hello%") == text_trigrams("hello"));
+   REQUIRE(like_pattern_trigrams("%ab_cd%ef") == std::vector<trigram_t>{});
+
+   auto expected = text_trigrams("abcd");
+   const auto second = text_trigrams("xyz");
+   expected.insert(std::end(expected), std::begin(second), std::end(second));
+   sort_unique(expected);
+   REQUIRE(like_pattern_trigrams("abcd%xyz") == expected);
+}
+
+TEST_CASE("Trigram filter - all trigrams of the added text are present", "[trigrams]") {
+   trigram_filter_words_t words;
+   add_to_trigram_filter("Hello world", words);
+
+   for (const auto trigram : like_pattern_trigrams("%LO WOR%")) {
+      for (const auto &bit : trigram_filter_bits(trigram)) {
+         REQUIRE(bit.word >= 0);
+         REQUIRE(bit.word < (1 << (trigram_filter_size_bits - 6)));
+         REQUIRE((words[bit.word] & bit.mask) != 0);
+      }
+   }
+}